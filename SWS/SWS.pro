@@ -1,7 +1,7 @@
 QT += core
 QT -= gui
 
-CONFIG += c++11
+CONFIG += c++11 thread
 
 TARGET = SWS
 CONFIG += console
@@ -11,8 +11,16 @@ TEMPLATE = app
 
 SOURCES += main.cpp \
     game.cpp \
+    game_arena.cpp \
     card.cpp \
     klondike.cpp \
+    klondike_state.cpp \
+    klondike_solver.cpp \
+    klondike_hint.cpp \
+    freecell_rules.cpp \
+    solitaire.cpp \
+    variant.cpp \
+    transposition_table.cpp \
     command.cpp \
     console.cpp
 
@@ -22,6 +30,9 @@ SOURCES += main.cpp \
 # deprecated API in order to know how to port your code away from it.
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# Debug builds check the running table hash against a full recompute on every move
+CONFIG(debug, debug|release): DEFINES += SWS_DEBUG_HASH
+
 # You can also make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
@@ -29,8 +40,26 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 HEADERS += \
     game.h \
+    game_arena.h \
     card.h \
+    card_stack.h \
     klondike.h \
+    klondike_state.h \
+    klondike_rules.h \
+    klondike_solver.h \
+    klondike_hint.h \
+    freecell_rules.h \
+    spider_rules.h \
+    rules_solver.h \
+    solitaire.h \
+    variant.h \
+    transposition_table.h \
     command.h \
     console.h \
     game_common.h
+
+# Game server uses POSIX sockets
+unix {
+    SOURCES += server.cpp
+    HEADERS += server.h
+}
@@ -9,44 +9,64 @@ using namespace std;
 ////////////////////////
 // Deck class methods
 
-// Init Deck object
-Deck::Deck(DeckType_t deckType)
+// Init Deck object; 'deckCount' copies of the suits of 'deckType' (e.g. Spider's
+//   104 cards are 2 standard decks or 8 single-suit ones); as many whole copies
+//   as fit in 'MAX_CARDS_PER_DECK'
+Deck::Deck(DeckType_t deckType, int deckCount)
 {
-    int suitMax = deckType;
-    int suitId;
-    int cardId;
+    int copyCards = deckType * CARDS_PER_STD_SUIT;
 
-    // Create cards and append to list
-    for (suitId = HEARTS; suitId < suitMax; suitId++)
+    if (deckCount > MAX_CARDS_PER_DECK / copyCards) deckCount = MAX_CARDS_PER_DECK / copyCards;
+    type = deckType;
+    cardCount = deckCount * copyCards;
+    reset();
+}
+
+// Put cards back in new-deck order
+void Deck::reset()
+{
+    int suitMax = type;
+    int i = 0;
+
+    while (i < cardCount)
     {
-        for (cardId = ACE; cardId <= KING; cardId++)
+        for (auto suitId = (int)HEARTS; suitId < suitMax; suitId++)
         {
-            cardList.append(new Card((CardSuit_t)suitId, (CardValue_t)cardId));
+            for (auto cardId = (int)ACE; cardId <= (int)KING; cardId++)
+            {
+                cards[i++] = Card((CardSuit_t)suitId, (CardValue_t)cardId);
+            }
         }
     }
 }
 
-// Shuffle deck and return seed
-unsigned Deck::shuffle(unsigned seed)
+// Shuffle deck with given deal generator and return seed
+unsigned Deck::shuffle(unsigned seed, DealVersion_t version)
 {
+    quint64 state = seed;
+
     if (seed == INVALID_SEED)
     {
         seed = chrono::system_clock::now().time_since_epoch().count();
+        state = seed;
     }
-    std::shuffle(cardList.begin(), cardList.end(), default_random_engine(seed));
-
-    return seed;
-}
-
 
-////////////////////////
-// Card class methods
+    switch (version)
+    {
+    case DEAL_LEGACY:
+        std::shuffle(cards, cards + cardCount, default_random_engine(seed));
+        break;
 
-// Init Card object
-Card::Card(CardSuit_t cardSuit, CardValue_t cardValue, CardState_t cardState)
-{
-    suit = cardSuit;
-    value = cardValue;
+    case DEAL_V1:
+    default:
+        // Fisher-Yates from the top down
+        for (auto i = cardCount - 1; i > 0; i--)
+        {
+            swap(cards[i], cards[BoundedDraw(state, i + 1)]);
+        }
+        break;
+    }
 
-    faceUp = (cardState == FACE_UP)? true : false;
+    return seed;
 }
+
@@ -2,14 +2,26 @@
 #define CARD_H
 
 #include <QVector>
+#include <cstring>
 
 
 #define SUITS_PER_STD_DECK  (4)
 #define CARDS_PER_STD_SUIT  (13)
 #define CARDS_PER_STD_DECK  (SUITS_PER_STD_DECK * CARDS_PER_STD_SUIT)
 
+#define MAX_DECKS_PER_GAME  (2)
+#define MAX_CARDS_PER_DECK  (MAX_DECKS_PER_GAME * STD_DECK * CARDS_PER_STD_SUIT)  // Largest deck a game deals
+
 #define INVALID_SEED  (0)
 
+// Index of card within a standard deck, suit-major; bit position in a 'CardMask_t'
+#define CARD_INDEX(c)   ((c).getSuit() * CARDS_PER_STD_SUIT + (c).getValue() - ACE)
+#define CARD_BIT(c)     (1ULL << CARD_INDEX(c))
+#define CARD_MASK_ALL   ((1ULL << CARDS_PER_STD_DECK) - 1)
+#define SUIT_MASK(s)    (((1ULL << CARDS_PER_STD_SUIT) - 1) << ((s) * CARDS_PER_STD_SUIT))
+
+typedef quint64 CardMask_t;  // Set of standard deck cards
+
 
 // Suit values
 typedef enum
@@ -46,7 +58,7 @@ typedef enum
     FACE_UP
 } CardState_t;
 
-// Deck types
+// Deck types; value is the number of suits
 typedef enum
 {
     ONE_SUIT_DECK   = 1,
@@ -55,41 +67,109 @@ typedef enum
     STD_DECK        = 4
 } DeckType_t;
 
+// Deal generator versions; deals for a released version never change
+typedef enum
+{
+    DEAL_LEGACY = 0,  // std::shuffle over std::default_random_engine; library dependent
+    DEAL_V1     = 1,  // SplitMix64 draws with explicit Fisher-Yates; portable
+    DEAL_VERSION_COUNT,
+    INVALID_DEAL_VERSION = DEAL_VERSION_COUNT  // Not a known version
+} DealVersion_t;
+#define DEAL_CURRENT  (DEAL_V1)
+
 
-class Deck
+// Packed card code layout
+#define CARD_VALUE_MASK   (0x0f)  // Bits 0-3: face value
+#define CARD_SUIT_SHIFT   (4)     // Bits 4-5: suit
+#define CARD_SUIT_MASK    (0x03 << CARD_SUIT_SHIFT)
+#define CARD_FACE_UP_BIT  (0x40)  // Bit 6: face state
+#define CARD_NULL_BIT     (0x80)  // Bit 7: no card (empty slot)
+
+
+// Card value type; suit, value and face state packed into a single byte
+class Card
 {
 public:
-    Deck(DeckType_t deckType = STD_DECK);
+    Card(CardSuit_t cardSuit    = SPADES,
+         CardValue_t cardValue  = ACE,
+         CardState_t cardState  = FACE_DOWN)
+        : code((quint8)(cardValue | (cardSuit << CARD_SUIT_SHIFT) |
+                        ((cardState == FACE_UP)? CARD_FACE_UP_BIT : 0))) {}
+
+    static inline Card nullCard()  { Card card; card.code = CARD_NULL_BIT; return card; }
+    static inline Card fromCode(quint8 cardCode)  { Card card; card.code = cardCode; return card; }
+    inline bool isNull() const     { return (code & CARD_NULL_BIT) != 0; }
+
+    inline CardSuit_t getSuit() const  { return (CardSuit_t)((code & CARD_SUIT_MASK) >> CARD_SUIT_SHIFT); }
+    inline bool isRed() const          { return (getSuit() < CLUBS); }
+
+    inline CardValue_t getValue() const  { return (CardValue_t)(code & CARD_VALUE_MASK); }
 
-    QVector<class Card *> & getCardList()  { return cardList; }
+    inline bool isFaceUp() const  { return (code & CARD_FACE_UP_BIT) != 0; }
+    inline void flipFaceUp()      { code |= CARD_FACE_UP_BIT; }
+    inline void flipFaceDown()    { code &= ~CARD_FACE_UP_BIT; }
+    inline void turnOver()        { code ^= CARD_FACE_UP_BIT; }
 
-    unsigned shuffle(unsigned seed = INVALID_SEED);
+    inline quint8 getCode() const  { return code; }
+
+    inline bool operator==(const Card &other) const  { return code == other.code; }
+    inline bool operator!=(const Card &other) const  { return code != other.code; }
 
 private:
-    QVector<class Card *> cardList;
+    quint8 code;
 };
+static_assert(sizeof(Card) == 1, "Card must pack into a single byte");
 
 
-class Card
+// Deck of cards stored inline, so it lives and dies with its owner
+class Deck
 {
 public:
-    Card(CardSuit_t cardSuit    = SPADES,
-         CardValue_t cardValue  = ACE,
-         CardState_t cardState  = FACE_DOWN);
+    Deck(DeckType_t deckType = STD_DECK, int deckCount = 1);
 
-    inline CardSuit_t getSuit()  { return suit; }
-    inline bool isRed()          { return (suit < CLUBS); }
+    inline int getCardCount() const  { return cardCount; }
+    inline Card getCard(int i) const  { return cards[i]; }
+    inline const Card * begin() const  { return cards; }
+    inline const Card * end() const    { return cards + cardCount; }
 
-    inline CardValue_t getValue()  { return value; }
+    inline bool operator==(const Deck &other) const
+        { return cardCount == other.cardCount && memcmp(cards, other.cards, cardCount) == 0; }
+    inline bool operator!=(const Deck &other) const  { return !(*this == other); }
 
-    inline bool isFaceUp()      { return faceUp; }
-    inline void flipFaceUp()    { faceUp = true; }
-    inline void flipFaceDown()  { faceUp = false; }
+    void reset();
+    unsigned shuffle(unsigned seed = INVALID_SEED, DealVersion_t version = DEAL_CURRENT);
 
 private:
-    CardSuit_t suit;
-    CardValue_t value;
-    bool faceUp;
+    Card cards[MAX_CARDS_PER_DECK];
+    int cardCount;
+    DeckType_t type;
 };
 
+
+// Next SplitMix64 output; plain 64-bit arithmetic gives the same stream on
+//   every platform
+inline quint64 SplitMix64(quint64 &state)
+{
+    quint64 z = (state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+// Unbiased draw in [0, range) by multiply-shift with rejection
+inline quint32 BoundedDraw(quint64 &state, quint32 range)
+{
+    quint64 m = (SplitMix64(state) >> 32) * range;
+
+    if ((quint32)m < range)
+    {
+        quint32 threshold = (0u - range) % range;
+        while ((quint32)m < threshold) m = (SplitMix64(state) >> 32) * range;
+    }
+
+    return (quint32)(m >> 32);
+}
+
 #endif // CARD_H
@@ -0,0 +1,80 @@
+#ifndef CARD_STACK_H
+#define CARD_STACK_H
+
+#include <cstring>
+#include "card.h"
+
+
+// Smallest power of 2 not less than 'n'
+constexpr int NextPow2(int n, int p = 1)  { return (p >= n)? p : NextPow2(n, p << 1); }
+
+#define PILE_CAPACITY       (NextPow2(MAX_CARDS_PER_DECK))
+
+
+// Fixed-capacity ring of cards stored inline; O(1) push/pop at both ends,
+//   no heap traffic and no shared data
+template <int Capacity>
+class CardStack
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "CardStack capacity must be a power of 2");
+
+public:
+    CardStack() : head(0), count(0) {}
+
+    static inline int capacity()  { return Capacity; }
+    inline int size() const       { return count; }
+    inline bool empty() const     { return (count == 0); }
+    inline bool isFull() const    { return (count == Capacity); }
+
+    inline Card value(int i, Card defaultCard) const
+        { return ((unsigned)i < (unsigned)count)? cards[slot(i)] : defaultCard; }
+    inline Card & operator[](int i)  { return cards[slot(i)]; }
+    inline Card & first()  { return cards[head]; }
+    inline Card & last()   { return cards[slot(count - 1)]; }
+
+    inline void push_back(Card card)   { Q_ASSERT(!isFull()); cards[slot(count++)] = card; }
+    inline void push_front(Card card)  { Q_ASSERT(!isFull()); head = (head - 1) & MASK; cards[head] = card; count++; }
+    inline void pop_back()   { Q_ASSERT(!empty()); count--; }
+    inline void pop_front()  { Q_ASSERT(!empty()); head = (head + 1) & MASK; count--; }
+    inline void clear()      { head = 0; count = 0; }
+
+    void spliceTo(CardStack &dst, int n);
+
+private:
+    static const int MASK = Capacity - 1;
+
+    inline int slot(int i) const  { return (head + i) & MASK; }
+
+    Card cards[Capacity];
+    int head;
+    int count;
+};
+
+// Move top 'n' cards (order preserved) onto back of 'dst'; caller checks sizes
+template <int Capacity>
+void CardStack<Capacity>::spliceTo(CardStack &dst, int n)
+{
+    int srcIdx = slot(count - n);
+    int dstIdx = dst.slot(dst.count);
+    int left = n;
+
+    Q_ASSERT(n <= count && dst.count + n <= Capacity);
+
+    // Copy in contiguous runs; at most three when either ring wraps
+    while (left > 0)
+    {
+        int chunk = left;
+        if (chunk > Capacity - srcIdx) chunk = Capacity - srcIdx;
+        if (chunk > Capacity - dstIdx) chunk = Capacity - dstIdx;
+
+        memcpy(&dst.cards[dstIdx], &cards[srcIdx], chunk * sizeof(Card));
+        srcIdx = (srcIdx + chunk) & MASK;
+        dstIdx = (dstIdx + chunk) & MASK;
+        left -= chunk;
+    }
+
+    count -= n;
+    dst.count += n;
+}
+
+#endif // CARD_STACK_H
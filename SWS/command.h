@@ -18,6 +18,7 @@ typedef enum
     CS_MISSING_ARGS,
     CS_TOO_MANY_ARGS,
     CS_BAD_MOVE     = 20,
+    CS_END_OF_INPUT = 30,
     CS_ERROR        = 50
 } CmdError_t;
 
@@ -32,7 +33,9 @@ typedef enum
     _QUIT_CMD,
     _UNDO_CMD,
     _REDO_CMD,
-    _FORCE_CMD
+    _FORCE_CMD,
+    _HINT_CMD,
+    _DEAL_CMD
 } CmdId_t;
 
 // Cdb pile item identifier
@@ -55,6 +58,7 @@ typedef struct _Cdb_t
         };
         CdbPileItem_t arg[CDB_MAX_ARG_COUNT];
     };
+    int count;  // Cards moved; '0' unless given in the command, then set by command validation
 } Cdb_t;
 
 #endif // COMMAND_H
@@ -1,4 +1,4 @@
-#include <QMap>
+#include <climits>
 #include <QDebug>
 #include "console.h"
 #include "command.h"
@@ -36,161 +36,193 @@ const char *cardStrMatrix[][2] =
 #define CARD_LINE(line, state)  (cardStrMatrix[line][state])
 #define CARD_LINE_1_ALT         (strTable[1])
 
+#define GLYPH_LINE_ALT  (CARD_HEIGHT)             // Atlas line for top of a card overlapping another
+#define GLYPH_NULL      (CARD_NULL_BIT)           // Atlas entry for null card; follows all card codes
+#define GLYPH_COUNT     (GLYPH_NULL + 1)
+#define GLYPH_IDX(c)    ((c).isNull()? GLYPH_NULL : (c).getCode())
 
-CmdError_t getCmdId(const QString &str, CmdId_t &cmdId);
-CmdError_t getArg(const QString &str, CdbPileItem_t &pileItem);
+// Card glyph atlas; each line of each card code and face state, plus the
+//   overlapped top line
+typedef struct _CardGlyphs_t
+{
+    char line[GLYPH_COUNT][CARD_HEIGHT + 1][CARD_WIDTH];
+} CardGlyphs_t;
 
+// Build glyph atlas from card segment matrix
+static CardGlyphs_t buildCardGlyphs()
+{
+    CardGlyphs_t glyphs;
 
-////////////////////////////////
-// GameConsole class methods
+    for (auto idx = 0; idx < GLYPH_COUNT; idx++)
+    {
+        Card card = (idx == GLYPH_NULL)? Card::nullCard() : Card::fromCode(idx);
+        bool showFace = card.isNull() || card.isFaceUp(); // Null card prints as empty outline
+
+        for (auto l = 0; l < CARD_HEIGHT; l++)
+        {
+            memcpy(glyphs.line[idx][l], CARD_LINE(l, showFace), CARD_WIDTH);
+        }
+        memcpy(glyphs.line[idx][GLYPH_LINE_ALT], CARD_LINE_1_ALT, CARD_WIDTH);
+
+        // Add card info for face-up cards
+        if (card.isNull() || !card.isFaceUp() || card.getValue() < ACE || card.getValue() > KING) continue;
 
-GameConsole::GameConsole()
+        const char *pValue = GetCardInitialStr(card.getValue());
+        int valueLen = strlen(pValue);
+        memcpy(&glyphs.line[idx][1][1], pValue, valueLen);
+        glyphs.line[idx][2][3] = GetSuitInitialStr(card.getSuit())[0];
+        memcpy(&glyphs.line[idx][3][6 - valueLen], pValue, valueLen);
+    }
+
+    return glyphs;
+}
+
+// Glyph atlas, built on first use
+static inline const CardGlyphs_t & cardGlyphs()
 {
+    static const CardGlyphs_t glyphs = buildCardGlyphs();
+    return glyphs;
 }
 
-// Standard output
-#define qout  QTextStream(stdout)
 
-// Standard input
-inline QTextStream & qIn(FILE *is = stdin)
+
+////////////////////////////////
+// GameConsole class methods
+
+GameConsole::GameConsole(FILE *outFile, RenderMode_t mode, FILE *inFile)
 {
-    static QTextStream s(is);
-    return s;
+    out = outFile;
+    in = inFile;
+    renderMode = mode;
+    prevWidth = 0;
+    layout.pileCount = 0;
+    lastOutputSize = 0;
 }
-#define qin  qIn()  // Assumes FILE ptr named 'is'
-#define consume()  readLine()  // Consume remaining words
 
 
 #define COL_WIDTH   (CARD_WIDTH + 1)
 #define ROW_HEIGHT  (CARD_HEIGHT + 2)  // Include room for pile headers
 #define TO_X_COORD(c)  ((c) * COL_WIDTH)
-#define TO_Y_COORD(r)  ((r) * ROW_HEIGHT + 1)  // Offset by 1 for pile headers
-// Return table width as determined by pile map configuration
-int GameConsole::calcTableWidth(PileMap_t &pileMap)
+#define TO_Y_COORD(r)  (layout.levelTop[r] + 1)  // Offset by 1 for pile headers
+// Lay out whole table from pile map configuration
+void GameConsole::layoutTable(PileMap_t &pileMap)
 {
     int x, y;
-    int tableWidth = 0;
+    int idx = 0;
+
+    layout.width = 0;
+    layout.levelCount = 0;
 
-    // Search piles for largest x-coordinate
-    for (auto pileVec : PILE_MAP)
+    // Columns from largest x-coordinate; levels from y-coordinates
+    for (auto pPile : PILE_MAP)
     {
-        for (auto pPile : pileVec)
-        {
-            pPile->getCoord(&x, &y);
-            if (++x > tableWidth) tableWidth = x;
-        }
+        pPile->getCoord(&x, &y);
+        if (++x > layout.width) layout.width = x;
+        if (y >= layout.levelCount) layout.levelCount = y + 1;
+        layout.pileLevel[idx] = y;
+        layout.pileHeight[idx] = -1; // Force height update
+        idx++;
     }
+    layout.width *= CARD_WIDTH + 1;
+    layout.pileCount = PILE_MAP.getPileCount();
 
-    return tableWidth * (CARD_WIDTH + 1);
+    for (auto l = 0; l < layout.levelCount; l++) layout.levelHeight[l] = 0;
+    updateLayout(pileMap, PILE_MASK_ALL);
 }
 
-// Return table height as determined by pile map configuration
-int GameConsole::calcTableHeight(PileMap_t &pileMap)
+// Update heights of changed piles, and of the levels holding them
+void GameConsole::updateLayout(PileMap_t &pileMap, quint32 dirtyMask)
 {
-    int x, y;
-    int h;
-    int cardCnt;
-    QVector<int> heightV;
-    int tableHeight = 0;
+    quint32 levelMask = 0;
+
+    // Re-measure dirty piles
+    for (auto idx = 0; idx < layout.pileCount; idx++)
+    {
+        if ((dirtyMask & PILE_BIT(idx)) == 0) continue;
+
+        int h = calcPileHeight(PILE_MAP.at(idx));
+        if (h != layout.pileHeight[idx])
+        {
+            layout.pileHeight[idx] = h;
+            levelMask |= PILE_BIT(layout.pileLevel[idx]);
+        }
+    }
+    if (levelMask == 0) return;
 
-    // Search each level (y-coordinate) for largest pile height
-    for (auto pileVec : PILE_MAP)
+    // Level height is its tallest pile
+    for (auto l = 0; l < layout.levelCount; l++)
     {
-        for (auto pPile : pileVec)
+        if ((levelMask & PILE_BIT(l)) == 0) continue;
+
+        layout.levelHeight[l] = 0;
+        for (auto idx = 0; idx < layout.pileCount; idx++)
         {
-            pPile->getCoord(&x, &y);
-            if (y >= heightV.size()) heightV.push_back(0); // Check for new level
-            switch (pPile->getPrintStyle())
+            if (layout.pileLevel[idx] == l && layout.pileHeight[idx] > layout.levelHeight[l])
             {
-            case NOTHING:
-                break;
-            case CASCADE:
-                cardCnt = pPile->getCardCount();
-                if (cardCnt == 0) h = ROW_HEIGHT;
-                else
-                {
-                    Card *pCard = pPile->bottomCard();
-                    h = 0;
-                    do
-                    {
-                        if (pPile->getCard(PREVIOUS) != nullptr)
-                        {
-                            // Reduce line count for overlap
-                            h += (pCard->isFaceUp())? CARD_HEIGHT_OVERLAP : CARD_HEIGHT_OVERLAP_FACE_DOWN;
-                        }
-                        else h += ROW_HEIGHT;
-                        pCard = pPile->prevCard();
-                    } while(pCard != nullptr);
-                }
-                break;
-            default:
-                h = ROW_HEIGHT;
+                layout.levelHeight[l] = layout.pileHeight[idx];
             }
-            if (h > heightV[y]) heightV[y] = h;
         }
     }
 
-    // Sum level heights
-    for (auto val : heightV) tableHeight += val;
-
-    return tableHeight;
+    // Levels stack in order; one that measures nothing takes no lines
+    layout.height = 0;
+    for (auto l = 0; l < layout.levelCount; l++)
+    {
+        layout.levelTop[l] = layout.height;
+        layout.height += layout.levelHeight[l];
+    }
 }
 
-#define TABLE_STR_COORD_IDX(x, y)       (((y) * table.width) + (x))
-#define TABLE_STR_REPLACE(str, i, n)    (table.pStr->replace((i), n, str))
-#define TABLE_CARD_STR_REPLACE(str, i)  TABLE_STR_REPLACE(str, i, CARD_WIDTH)
-#define TABLE_IMPRINT(i, c, l)          TABLE_CARD_STR_REPLACE(CARD_LINE(l, ((c == nullptr)? true : c->isFaceUp())), i);
-// Imprint single card to print string; return number of lines printed
-int GameConsole::imprintCard(Card *pCard, ConsoleTable_t &table, int strIdx, bool overlapBelow, bool overlapAbove)
+// Return printed height of pile in lines
+int GameConsole::calcPileHeight(Pile *pPile)
 {
-    int i = strIdx;
-    int l;
-    int lineCnt;
+    int cardCnt = pPile->getCardCount();
+    int h;
 
-    // Imprint alternative first card line if necessary
-    if (overlapBelow)
+    switch (pPile->getPrintStyle())
     {
-        TABLE_CARD_STR_REPLACE(CARD_LINE_1_ALT, i);
-        i += table.width;
-        l = 1;
+    case NOTHING:
+        return 0;
+
+    case CASCADE:
+        if (cardCnt == 0) return ROW_HEIGHT;
+
+        // Overlapped cards show fewer lines; top card shows all
+        h = ROW_HEIGHT;
+        for (auto i = 0; i < cardCnt - 1; i++)
+        {
+            h += (pPile->getCardAt(i).isFaceUp())? CARD_HEIGHT_OVERLAP : CARD_HEIGHT_OVERLAP_FACE_DOWN;
+        }
+        return h;
+
+    default:
+        return ROW_HEIGHT;
     }
-    else l = 0;
+}
+
+#define TABLE_COORD_IDX(x, y)  (((y) * table.width) + (x))
+// Imprint single card to table buffer from glyph atlas; return number of lines
+//   printed, counting any clipped at the bottom of the table
+int GameConsole::imprintCard(Card card, ConsoleTable_t &table, int idx, bool overlapBelow, bool overlapAbove)
+{
+    const char (*pGlyph)[CARD_WIDTH] = cardGlyphs().line[GLYPH_IDX(card)];
+    char *pDst = table.pBuf + idx;
+    const char *pEnd = table.pBuf + table.height * table.width;
+    int lineCnt;
 
     // Set number of lines to be printed based on card/pile state
     if (overlapAbove)
     {
         // Reduce 'lineCnt' for overlap
-        lineCnt = (pCard->isFaceUp())? CARD_HEIGHT_OVERLAP : CARD_HEIGHT_OVERLAP_FACE_DOWN;
+        lineCnt = (card.isFaceUp())? CARD_HEIGHT_OVERLAP : CARD_HEIGHT_OVERLAP_FACE_DOWN;
     }
     else lineCnt = CARD_HEIGHT;
 
-    // Imprint remaining card lines
-    for (; l < lineCnt; l++)
+    // Alternative first line if card overlaps another
+    for (auto l = 0; l < lineCnt && pDst < pEnd; l++)
     {
-        TABLE_IMPRINT(i, pCard, l);
-
-        // Add card info for face-up cards
-        if (pCard != nullptr && pCard->isFaceUp())
-        {
-            QString cardValue;
-
-            switch (l)
-            {
-            case 1:
-                cardValue = QString(GetCardInitialStr(pCard->getValue()));
-                TABLE_STR_REPLACE(cardValue, i + 1, cardValue.size());
-                break;
-            case 2:
-                TABLE_STR_REPLACE(GetSuitInitialStr(pCard->getSuit()), i + 3, 1);
-                break;
-            case 3:
-                cardValue = QString(GetCardInitialStr(pCard->getValue()));
-                TABLE_STR_REPLACE(cardValue, i + 6 - cardValue.size(), cardValue.size());
-                break;
-            }
-        }
-
-        i += table.width;
+        memcpy(pDst, pGlyph[(l == 0 && overlapBelow)? GLYPH_LINE_ALT : l], CARD_WIDTH);
+        pDst += table.width;
     }
 
     return lineCnt;
@@ -201,48 +233,36 @@ void GameConsole::imprintPile(Pile *pPile, ConsoleTable_t &table)
 {
     int col, row;
     int x, y;
-    Card *pCard;
-    bool overlapBelow;
-    bool overlapAbove;
+    int cardCnt = pPile->getCardCount();
+
+    pPile->getCoord(&col, &row);
+    x = TO_X_COORD(col);
+    y = TO_Y_COORD(row);
 
     switch (pPile->getPrintStyle())
     {
     case CASCADE:
-        pCard = pPile->bottomCard();
-        pPile->getCoord(&col, &row);
-        x = TO_X_COORD(col);
-        y = TO_Y_COORD(row);
-        do
+        if (cardCnt == 0)
+        {
+            imprintCard(Card::nullCard(), table, TABLE_COORD_IDX(x, y), false, false);
+            break;
+        }
+        for (auto i = 0; i < cardCnt; i++)
         {
-            overlapBelow = (pPile->getCard(NEXT) != nullptr);
-            overlapAbove = (pPile->getCard(PREVIOUS) != nullptr);
-            y += imprintCard(pCard, table, TABLE_STR_COORD_IDX(x, y), overlapBelow, overlapAbove);
-            pCard = pPile->prevCard();
-        } while (pCard != nullptr);
+            y += imprintCard(pPile->getCardAt(i), table, TABLE_COORD_IDX(x, y), i > 0, i < cardCnt - 1);
+        }
         break;
 
     case BOTTOM_CARD_ONLY:
-        pPile->getCoord(&col, &row);
-        x = TO_X_COORD(col);
-        y = TO_Y_COORD(row);
-        imprintCard(pPile->bottomCard(), table, TABLE_STR_COORD_IDX(x, y), false, false);
+        imprintCard(pPile->getCardAt(0), table, TABLE_COORD_IDX(x, y), false, false);
         break;
 
     case BOTTOM_CARD_NO_NULL:
-        if (pPile->getCardCount() > 0)
-        {
-            pPile->getCoord(&col, &row);
-            x = TO_X_COORD(col);
-            y = TO_Y_COORD(row);
-            imprintCard(pPile->bottomCard(), table, TABLE_STR_COORD_IDX(x, y), false, false);
-        }
+        if (cardCnt > 0) imprintCard(pPile->getCardAt(0), table, TABLE_COORD_IDX(x, y), false, false);
         break;
 
     case TOP_CARD_ONLY:
-        pPile->getCoord(&col, &row);
-        x = TO_X_COORD(col);
-        y = TO_Y_COORD(row);
-        imprintCard(pPile->topCard(), table, TABLE_STR_COORD_IDX(x, y), false, false);
+        imprintCard(pPile->getCardAt(cardCnt - 1), table, TABLE_COORD_IDX(x, y), false, false);
         break;
 
     default:
@@ -250,80 +270,211 @@ void GameConsole::imprintPile(Pile *pPile, ConsoleTable_t &table)
     }
 }
 
-// Construct and print game table to console
-void GameConsole::printTable(PileMap_t &pileMap)
+// Draw table into frame buffer; returns empty frame if table has no size
+const QByteArray & GameConsole::renderTable(PileMap_t &pileMap, quint32 dirtyMask)
 {
     ConsoleTable_t table;
-    int tableWidth = calcTableWidth(pileMap);
-    int tableHeight = calcTableHeight(pileMap);
+
+    // Relayout on new pile configuration, else just the changed piles
+    if (layout.pileCount != PILE_MAP.getPileCount()) layoutTable(pileMap);
+    else if (dirtyMask != 0) updateLayout(pileMap, dirtyMask);
 
     // Sanity check dimensions
-    if (tableWidth == 0 || tableHeight == 0) return;
+    if (layout.width == 0 || layout.height == 0)
+    {
+        frame.resize(0);
+        return frame;
+    }
 
-    // Create table
-    QString tableStr(tableHeight * tableWidth, ' ');
-    table.pStr = &tableStr;
-    table.width = tableWidth;
-    for (auto line = 1; line <= tableHeight; line++)
+    // Blank frame with line ends; buffer is reused between frames
+    frame.resize(layout.height * layout.width);
+    table.pBuf = frame.data();
+    table.width = layout.width;
+    table.height = layout.height;
+    memset(table.pBuf, ' ', frame.size());
+    for (auto line = 1; line <= layout.height; line++)
     {
-        tableStr[line * tableWidth - 1] = '\n';
+        table.pBuf[line * layout.width - 1] = '\n';
     }
 
     // Imprint piles
-    for (auto pileVec : PILE_MAP)
+    for (auto pPile : PILE_MAP)
+    {
+        imprintPile(pPile, table);
+    }
+
+    return frame;
+}
+
+// Construct and print game table to console
+void GameConsole::printTable(PileMap_t &pileMap, quint32 dirtyMask)
+{
+    if (renderTable(pileMap, dirtyMask).isEmpty()) return;
+
+    if (renderMode == RENDER_DIFF)
+    {
+        renderDiff(layout.width, layout.height);
+        return;
+    }
+
+    fwrite(frame.constData(), 1, frame.size(), out);
+    lastOutputSize = frame.size();
+}
+
+#define ANSI_CLEAR_SCREEN  "\x1b[H\x1b[2J"  // Home cursor and clear
+#define ANSI_CLEAR_BELOW   "\x1b[J"
+#define DIFF_MERGE_GAP     (6)  // Unchanged cells worth rewriting to save a cursor move
+// Write changes from last frame; table is drawn from top left of screen and
+//   cursor left on the line below it
+void GameConsole::renderDiff(int tableWidth, int tableHeight)
+{
+    QByteArray outBuf;
+    char cursorStr[32];
+
+    if (prevFrame.isEmpty() || tableWidth != prevWidth)
     {
-        for (auto pPile : pileVec)
+        // Full redraw
+        outBuf.reserve(frame.size() + 16);
+        outBuf.append(ANSI_CLEAR_SCREEN);
+        outBuf.append(frame);
+    }
+    else
+    {
+        // Rows below last frame were cleared, so compare them against blanks
+        QByteArray blankLine(tableWidth, ' ');
+        int prevHeight = prevFrame.size() / tableWidth;
+
+        for (auto row = 0; row < tableHeight; row++)
         {
-            imprintPile(pPile, table);
+            const char *pNew = frame.constData() + row * tableWidth;
+            const char *pOld = (row < prevHeight)? prevFrame.constData() + row * tableWidth : blankLine.constData();
+            int col = 0;
+
+            // Scan line (less newline) for runs of changed cells
+            while (col < tableWidth - 1)
+            {
+                if (pNew[col] == pOld[col])
+                {
+                    col++;
+                    continue;
+                }
+
+                // Extend run across short gaps of unchanged cells
+                int end = col + 1;
+                for (auto c = end, same = 0; c < tableWidth - 1 && same <= DIFF_MERGE_GAP; c++)
+                {
+                    if (pNew[c] == pOld[c]) same++;
+                    else
+                    {
+                        same = 0;
+                        end = c + 1;
+                    }
+                }
+
+                snprintf(cursorStr, sizeof(cursorStr), "\x1b[%d;%dH", row + 1, col + 1);
+                outBuf.append(cursorStr);
+                outBuf.append(pNew + col, end - col);
+                col = end;
+            }
         }
+
+        // Park cursor below table
+        snprintf(cursorStr, sizeof(cursorStr), "\x1b[%d;1H", tableHeight + 1);
+        outBuf.append(cursorStr);
     }
+    outBuf.append(ANSI_CLEAR_BELOW); // Drop leftover rows and old input
+
+    fwrite(outBuf.constData(), 1, outBuf.size(), out);
+    fflush(out);
+    lastOutputSize = outBuf.size();
 
-    qout << tableStr;
+    prevFrame.swap(frame);
+    prevWidth = tableWidth;
 }
 
 // Collect console input
 CmdError_t GameConsole::collectInput(Cdb_t &cdb)
 {
-    QString cmdStr;
-    QStringList wordList;
+    int len;
 
-    // Collect console input and parse
-    cmdStr = qin.readLine();
-    wordList = cmdStr.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    // Read line into fixed buffer; one that does not fit is dropped unparsed
+    if (fgets(lineBuf, sizeof(lineBuf), in) == nullptr)
+    {
+        cdb.cmdId = _INVALID_CMD;
+        return CS_END_OF_INPUT;
+    }
+    len = strlen(lineBuf);
+    if (len == sizeof(lineBuf) - 1 && lineBuf[len - 1] != '\n')
+    {
+        int c = fgetc(in);
+        if (c != '\n' && c != EOF)
+        {
+            do c = fgetc(in); while (c != '\n' && c != EOF);
+            cdb.cmdId = _INVALID_CMD;
+            return CS_BAD_CMD;
+        }
+    }
 
-    return tokenize(cdb, wordList); // Tokenize parsed input
+    return tokenize(cdb, lineBuf, len); // Tokenize raw input
 }
 
 // Fake console input
 CmdError_t GameConsole::collectInput(Cdb_t &cdb, QTextStream &is)
 {
-    QString cmdStr;
-    QStringList wordList;
-
-    // Pull command string and parse
-    cmdStr = is.readLine();
-    wordList = cmdStr.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    QByteArray cmdStr = is.readLine().toLatin1();
 
-    return tokenize(cdb, wordList);
+    return tokenize(cdb, cmdStr.constData(), cmdStr.size());
 }
 
-CmdError_t GameConsole::tokenize(Cdb_t &cdb, const QStringList &wordList)
+#define IS_SPACE(c)  ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+#define TO_UPPER(c)  (((c) >= 'a' && (c) <= 'z')? (c) - ('a' - 'A') : (c))  // ASCII only; no locale lookup
+#define WORD_COUNT   (CDB_MAX_ARG_COUNT + 2)  // Command, args and card count
+#define IS_DIGIT(c)  ((c) >= '0' && (c) <= '9')
+// Tokenize raw command line in a single pass; no allocation
+CmdError_t GameConsole::tokenize(Cdb_t &cdb, const char *pStr, int len)
 {
+    const char *pEnd = pStr + len;
+    const char *pWord[WORD_COUNT];
+    int wordLen[WORD_COUNT];
+    int wordCnt = 0;
+    bool excess = false;
     CmdError_t status = CS_ERROR;
     int a;
 
+    // Locate words; anything past the last arg only counts as excess
+    for (;;)
+    {
+        while (pStr < pEnd && IS_SPACE(*pStr)) pStr++;
+        if (pStr == pEnd) break;
+        if (wordCnt == WORD_COUNT)
+        {
+            excess = true;
+            break;
+        }
+
+        pWord[wordCnt] = pStr;
+        while (pStr < pEnd && !IS_SPACE(*pStr)) pStr++;
+        wordLen[wordCnt] = pStr - pWord[wordCnt];
+        wordCnt++;
+    }
+
     // Collect command ID
-    status = getCmdId(wordList[0], cdb.cmdId);
+    if (wordCnt != 0) status = getCmdId(pWord[0], wordLen[0], cdb.cmdId);
+    else
+    {
+        cdb.cmdId = _INVALID_CMD;
+        status = CS_BAD_CMD;
+    }
 
     // Collect CDB args; after one fails to tokenize, all remaining will
-    //   be invalidated; excess words will be ignored
+    //   be invalidated
     for (a = 0; a < CDB_MAX_ARG_COUNT; a++)
     {
-        if (a + 1 >= wordList.size() && status == CS_OK) status = CS_MISSING_ARGS;
+        if (a + 1 >= wordCnt && status == CS_OK) status = CS_MISSING_ARGS;
         if (status == CS_OK)
         {
             // Collect input
-            status = getArg(wordList[a + 1], cdb.arg[a]);
+            status = getArg(pWord[a + 1], wordLen[a + 1], cdb.arg[a]);
         }
         else
         {
@@ -332,66 +483,137 @@ CmdError_t GameConsole::tokenize(Cdb_t &cdb, const QStringList &wordList)
             cdb.arg[a].id       = INVALID_PILE_ID;
         }
     }
-    if (a + 1 != wordList.size() && status == CS_OK) status = CS_TOO_MANY_ARGS;
+
+    // Optional card count after the args; a word that is not a number is excess
+    cdb.count = 0;
+    if (wordCnt == WORD_COUNT && status == CS_OK)
+    {
+        if (IS_DIGIT(pWord[WORD_COUNT - 1][0])) status = getCount(pWord[WORD_COUNT - 1], wordLen[WORD_COUNT - 1], cdb.count);
+        else excess = true;
+    }
+    if (excess && status == CS_OK) status = CS_TOO_MANY_ARGS;
 
     return status;
 }
 
-#define CMD_MAP_PAIR(c)  {STRINGIFY(c), _##c##_CMD}
-#define CMD_MAP_PAIRS    \
-    CMD_MAP_PAIR(CLEAR), \
-    CMD_MAP_PAIR(KEY),   \
-    {"HELP", _KEY_CMD},  \
-    CMD_MAP_PAIR(MOVE),  \
-    CMD_MAP_PAIR(FLIP),  \
-    CMD_MAP_PAIR(QUIT),  \
-    CMD_MAP_PAIR(UNDO),  \
-    CMD_MAP_PAIR(REDO),  \
-    CMD_MAP_PAIR(FORCE)
-// Parse command string; generate command ID
-CmdError_t GameConsole::getCmdId(const QString &str, CmdId_t &cmdId)
+// Case-insensitive match of word against upper-case keyword
+static inline bool matchWord(const char *pWord, int len, const char *pKey, int keyLen)
 {
-    static const QMap<QString, CmdId_t> CmdMap = { CMD_MAP_PAIRS };
-    QString s = str.toUpper();
+    if (len != keyLen) return false;
+    for (auto i = 0; i < len; i++)
+    {
+        if (TO_UPPER(pWord[i]) != pKey[i]) return false;
+    }
 
-    cmdId = CmdMap.value(s, _INVALID_CMD);
+    return true;
+}
+
+#define MATCH_CMD(c)  if (matchWord(pWord, len, STRINGIFY(c), sizeof(STRINGIFY(c)) - 1)) cmdId = _##c##_CMD
+// Parse command word; generate command ID; dispatch on first letter, then
+//   confirm the whole word
+CmdError_t GameConsole::getCmdId(const char *pWord, int len, CmdId_t &cmdId)
+{
+    cmdId = _INVALID_CMD;
+
+    switch (TO_UPPER(pWord[0]))
+    {
+    case 'C':
+        MATCH_CMD(CLEAR);
+        break;
+    case 'D':
+        MATCH_CMD(DEAL);
+        break;
+    case 'F':
+        MATCH_CMD(FLIP);
+        MATCH_CMD(FORCE);
+        break;
+    case 'H':
+        if (matchWord(pWord, len, "HELP", 4)) cmdId = _KEY_CMD;
+        else MATCH_CMD(HINT);
+        break;
+    case 'K':
+        MATCH_CMD(KEY);
+        break;
+    case 'M':
+        MATCH_CMD(MOVE);
+        break;
+    case 'Q':
+        MATCH_CMD(QUIT);
+        break;
+    case 'R':
+        MATCH_CMD(REDO);
+        break;
+    case 'U':
+        MATCH_CMD(UNDO);
+        break;
+    default:
+        break;
+    }
     if (cmdId == _INVALID_CMD) return CS_BAD_CMD;
 
     return CS_OK;
 }
 
-// Parse command pile arg
-#define PILE_TYPE_PAIRS \
-    {'D', DECK},        \
-    {'S', DISCARD},     \
-    {'W', WASTE},       \
-    {'F', FOUNDATION},  \
-    {'C', CELL},        \
-    {'T', TABLEAU}
-CmdError_t GameConsole::getArg(const QString &str, CdbPileItem_t &pileItem)
+// Parse command pile arg: pile letter and optional signed decimal ID
+CmdError_t GameConsole::getArg(const char *pWord, int len, CdbPileItem_t &pileItem)
 {
-    static const QMap<QChar, PileType_t> ArgPileMap = { PILE_TYPE_PAIRS };
-    QString s = str.toUpper();
+    const char *pEnd = pWord + len;
+    const char *p = pWord + 1;
+    bool negative = false;
+    qint64 id = 0;
     bool ok;
 
-    pileItem.pileType = ArgPileMap.value(s[0], INVALID_PILE_TYPE);
-    s.remove(0, 1);
-    pileItem.id = s.toInt(&ok, 10);
-    if (!ok)
+    switch (TO_UPPER(pWord[0]))
+    {
+    case 'D': pileItem.pileType = DECK;              break;
+    case 'S': pileItem.pileType = DISCARD;           break;
+    case 'W': pileItem.pileType = WASTE;             break;
+    case 'F': pileItem.pileType = FOUNDATION;        break;
+    case 'C': pileItem.pileType = CELL;              break;
+    case 'T': pileItem.pileType = TABLEAU;           break;
+    default:  pileItem.pileType = INVALID_PILE_TYPE; break;
+    }
+
+    // If no ID, default to 0
+    if (p == pEnd)
+    {
+        pileItem.id = 0;
+        ok = true;
+    }
+    else
     {
-        if (s.size() == 0)
+        if (*p == '+' || *p == '-') negative = (*p++ == '-');
+        ok = (p != pEnd);
+        for (; p < pEnd && ok; p++)
         {
-            // If no ID, default to 0
-            pileItem.id = 0;
-            ok = true;
+            ok = (*p >= '0' && *p <= '9');
+            id = id * 10 + (*p - '0');
+            if (id > INT_MAX) ok = false;
         }
-        else pileItem.id = INVALID_PILE_ID;
+        pileItem.id = ok? (int)(negative? -id : id) : INVALID_PILE_ID;
     }
     if (!ok || pileItem.pileType == INVALID_PILE_TYPE) return CS_BAD_ARG;
 
     return CS_OK;
 }
 
+// Parse card count arg: decimal, from 1 to about the cards of a double deck
+CmdError_t GameConsole::getCount(const char *pWord, int len, int &count)
+{
+    count = 0;
+    for (auto i = 0; i < len; i++)
+    {
+        if (!IS_DIGIT(pWord[i]) || count > CARDS_PER_STD_DECK * 2)
+        {
+            count = 0;
+            return CS_BAD_ARG;
+        }
+        count = count * 10 + (pWord[i] - '0');
+    }
+
+    return (count != 0)? CS_OK : CS_BAD_ARG;
+}
+
 
 ////////////////////////////////
 // Standard functions
@@ -6,11 +6,35 @@
 #include "command.h"
 
 
-// Table string control structure
+#define CONSOLE_LINE_MAX  (256)  // Command line buffer; a longer line is rejected whole
+
+
+// Table render modes
+typedef enum
+{
+    RENDER_FULL,  // Write whole table every frame
+    RENDER_DIFF   // Write only cells changed since last frame, by ANSI cursor addressing
+} RenderMode_t;
+
+// Cached table layout; pile heights in lines, levels are pile y-coordinates
+typedef struct _ConsoleLayout_t
+{
+    int pileCount;  // Piles laid out; '0' if layout invalid
+    int width;
+    int height;
+    int levelCount;
+    int pileLevel[MAX_PILES_PER_TABLE];
+    int pileHeight[MAX_PILES_PER_TABLE];
+    int levelHeight[MAX_PILES_PER_TABLE];
+    int levelTop[MAX_PILES_PER_TABLE];  // First line of level; sum of the heights above it
+} ConsoleLayout_t;
+
+// Table buffer control structure
 typedef struct _ConsoleTable_t
 {
-    QString *pStr;
+    char *pBuf;
     int width;
+    int height;  // Lines; nothing is written below
 } ConsoleTable_t;
 
 
@@ -24,22 +48,40 @@ const char * GetCardInitialStr(CardValue_t nameId);
 class GameConsole
 {
 public:
-    GameConsole();
+    GameConsole(FILE *outFile = stdout, RenderMode_t mode = RENDER_FULL, FILE *inFile = stdin);
 
-    void printTable(PileMap_t &pileMap);
+    void printTable(PileMap_t &pileMap, quint32 dirtyMask = PILE_MASK_ALL);
+    const QByteArray & renderTable(PileMap_t &pileMap, quint32 dirtyMask = PILE_MASK_ALL);
 
-    CmdError_t collectInput(Cdb_t &cdb);
+    inline void setRenderMode(RenderMode_t mode)  { renderMode = mode; invalidate(); }
+    inline void invalidate()  { prevFrame.clear(); layout.pileCount = 0; }  // Force full redraw and relayout
+    inline int getLastOutputSize() const  { return lastOutputSize; }
+
+    CmdError_t collectInput(Cdb_t &cdb);  // 'CS_END_OF_INPUT' once input is exhausted
     CmdError_t collectInput(Cdb_t &cdb, QTextStream &is);
+    CmdError_t tokenize(Cdb_t &cdb, const char *pStr, int len);
 
 private:
     QTextStream & qOut();
-    int calcTableWidth(PileMap_t &pileMap);
-    int calcTableHeight(PileMap_t &pileMap);
-    int imprintCard(Card *pCard, ConsoleTable_t &table, int strIdx, bool overlapBelow, bool overlapAbove);
+    void layoutTable(PileMap_t &pileMap);
+    void updateLayout(PileMap_t &pileMap, quint32 dirtyMask);
+    int calcPileHeight(Pile *pPile);
+    int imprintCard(Card card, ConsoleTable_t &table, int idx, bool overlapBelow, bool overlapAbove);
     void imprintPile(Pile *pPile, ConsoleTable_t &table);
-    CmdError_t tokenize(Cdb_t &cdb, const QStringList &wordList);
-    CmdError_t getCmdId(const QString &str, CmdId_t &cmdId);
-    CmdError_t getArg(const QString &str, CdbPileItem_t &pileItem);
+    CmdError_t getCmdId(const char *pWord, int len, CmdId_t &cmdId);
+    CmdError_t getArg(const char *pWord, int len, CdbPileItem_t &pileItem);
+    CmdError_t getCount(const char *pWord, int len, int &count);
+    void renderDiff(int tableWidth, int tableHeight);
+
+    FILE *out;  // Table output stream
+    FILE *in;   // Command input stream
+    char lineBuf[CONSOLE_LINE_MAX];
+    RenderMode_t renderMode;
+    ConsoleLayout_t layout;  // Layout of last table printed; one table per console
+    QByteArray frame;      // Current frame
+    QByteArray prevFrame;  // Last frame written in diff mode; empty if screen state unknown
+    int prevWidth;
+    int lastOutputSize;    // Bytes written for last frame
 };
 
 #endif // CONSOLE_H
@@ -0,0 +1,4 @@
+#include "freecell_rules.h"
+
+
+constexpr PileLayout_t FreeCellRules::layout[];
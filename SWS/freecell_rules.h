@@ -0,0 +1,341 @@
+#ifndef FREECELL_RULES_H
+#define FREECELL_RULES_H
+
+#include "game.h"
+
+
+#define FREECELL_CELL_COUNT        (4)
+#define FREECELL_FOUNDATION_COUNT  (4)
+#define FREECELL_TABLEAU_COUNT     (8)
+
+#define FREECELL_ADD_MOVE(st, si, dt, di, n)  \
+    do { GameMove_t &m = pMoves[moveCnt++]; m.srcType = (st); m.srcId = (si); m.dstType = (dt); m.dstId = (di); m.count = (n); } while (0)
+
+
+// FreeCell rules for 'RulesGame' and 'RulesSolver'; whole deck dealt face up
+//   to the tableau, runs move as far as free cells and empty piles allow
+class FreeCellRules
+{
+public:
+    static const DeckType_t deckType = STD_DECK;
+    static const int deckCount = 1;
+    static constexpr PileLayout_t layout[] = {
+        {CELL,       FREECELL_CELL_COUNT,       0, 0},
+        {FOUNDATION, FREECELL_FOUNDATION_COUNT, 4, 0},
+        {DECK,       1,                         8, 0},  // Empty once dealt
+        {TABLEAU,    FREECELL_TABLEAU_COUNT,    0, 1}
+    };
+    static const PileType_t dealPileType = TABLEAU;
+    static const DealMethod_t dealMethod = ALL_FACE_UP;
+    static const int dealCount = 0;
+
+    static inline void checkForWin(PileMap_t &pileMap, GameState_t &state);
+    static inline CmdError_t validateCommand(PileMap_t &pileMap, Cdb_t &cdb);
+    static inline GameError_t dealStock(Game &)  { return GS_ERROR; }  // No stock deal
+
+    static inline int genMoves(PileMap_t &pileMap, GameMove_t *pMoves);
+    static inline void playMove(Game &game, const GameMove_t &move);
+
+private:
+    static inline bool fitsFoundation(Card card, Pile *pPile);
+    static inline bool fitsTableau(Card card, Pile *pPile);
+    static inline int runLength(Pile *pPile);
+    static inline int maxRun(PileMap_t &pileMap, bool toEmpty);
+    static inline int foundationFor(PileMap_t &pileMap, Card card);
+    static inline bool isSafeHome(PileMap_t &pileMap, Card card);
+};
+
+
+// Card may be placed on foundation pile
+inline bool FreeCellRules::fitsFoundation(Card card, Pile *pPile)
+{
+    Card top = pPile->topCard();
+
+    if (top.isNull()) return card.getValue() == ACE;
+
+    return card.getSuit() == top.getSuit() && card.getValue() == top.getValue() + 1;
+}
+
+// Card may be placed on tableau pile
+inline bool FreeCellRules::fitsTableau(Card card, Pile *pPile)
+{
+    Card top = pPile->topCard();
+
+    if (top.isNull()) return true;
+
+    return top.isRed() != card.isRed() && top.getValue() == card.getValue() + 1;
+}
+
+// Length of alternating-colour descending run on top of pile
+inline int FreeCellRules::runLength(Pile *pPile)
+{
+    int cnt = pPile->getCardCount();
+    int len = (cnt != 0)? 1 : 0;
+
+    while (len < cnt)
+    {
+        Card upper = pPile->getCardAt(cnt - len);
+        Card lower = pPile->getCardAt(cnt - len - 1);
+        if (upper.isRed() == lower.isRed() || lower.getValue() != upper.getValue() + 1) break;
+        len++;
+    }
+
+    return len;
+}
+
+// Longest run that may move at once: one more than the free cells, doubled
+//   for each empty pile other than the destination
+inline int FreeCellRules::maxRun(PileMap_t &pileMap, bool toEmpty)
+{
+    int freeCells = 0;
+    int emptyPiles = 0;
+
+    for (auto pPile : PILE_VECTOR(CELL)) if (pPile->getCardCount() == 0) freeCells++;
+    for (auto pPile : PILE_VECTOR(TABLEAU)) if (pPile->getCardCount() == 0) emptyPiles++;
+    if (toEmpty && emptyPiles > 0) emptyPiles--;
+
+    return (freeCells + 1) << emptyPiles;
+}
+
+// Foundation accepting card, or -1; aces go to the first empty foundation
+inline int FreeCellRules::foundationFor(PileMap_t &pileMap, Card card)
+{
+    for (auto f = 0; f < PILE_VECTOR(FOUNDATION).size(); f++)
+    {
+        if (fitsFoundation(card, PILE(FOUNDATION, f))) return f;
+    }
+
+    return -1;
+}
+
+// Card can go home without ever being needed in the tableau again: both
+//   opposite-colour cards one rank lower are already home
+inline bool FreeCellRules::isSafeHome(PileMap_t &pileMap, Card card)
+{
+    int need = card.getValue() - 1;
+    int found = 0;
+
+    if (card.getValue() <= TWO) return true;
+    for (auto pPile : PILE_VECTOR(FOUNDATION))
+    {
+        Card top = pPile->topCard();
+        if (!top.isNull() && top.isRed() != card.isRed() && top.getValue() >= need) found++;
+    }
+
+    return found == 2;
+}
+
+// Won when nothing is left off the foundations
+inline void FreeCellRules::checkForWin(PileMap_t &pileMap, GameState_t &state)
+{
+    if (PILE_MAP.isIndexed())
+    {
+        if (PILE_MAP.getCardMask(FOUNDATION) == PILE_MAP.getTableMask()) state = GAME_WON;
+        return;
+    }
+
+    for (auto pPile : PILE_MAP)
+    {
+        if (pPile->getType() != FOUNDATION && pPile->getCardCount() != 0) return;
+    }
+    state = GAME_WON;
+}
+
+// Validate command against table; sets card count of a move, which must match
+//   any count given in the command
+inline CmdError_t FreeCellRules::validateCommand(PileMap_t &pileMap, Cdb_t &cdb)
+{
+    Pile *pSrcPile;
+    Pile *pDstPile;
+    int given = cdb.count;
+    int run, limit;
+
+    cdb.count = 0;
+    switch (cdb.cmdId)
+    {
+    case _CLEAR_CMD:
+    case _KEY_CMD:
+    case _QUIT_CMD:
+    case _UNDO_CMD:
+    case _REDO_CMD:
+    case _HINT_CMD:
+        return CS_OK;
+
+    case _DEAL_CMD:
+        return CS_BAD_MOVE; // Whole deck is dealt at the start
+
+    case _MOVE_CMD:
+    case _FORCE_CMD:
+        if (!IS_VALID_PILE_TYPE(cdb.src.pileType) || !IS_VALID_PILE_TYPE(cdb.dst.pileType)) return CS_MISSING_ARGS;
+        if (!PILE_MAP.contains(cdb.src.pileType, cdb.src.id)) return CS_BAD_ARG_1;
+        if (!PILE_MAP.contains(cdb.dst.pileType, cdb.dst.id)) return CS_BAD_ARG_2;
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        pDstPile = PILE(cdb.dst.pileType, cdb.dst.id);
+        if (pSrcPile == pDstPile || pSrcPile->getCardCount() == 0) return CS_BAD_MOVE;
+        cdb.count = 1;
+
+        // Forced move skips the rules; top card only
+        if (cdb.cmdId == _FORCE_CMD) return (given <= 1)? CS_OK : CS_BAD_MOVE;
+        if (cdb.src.pileType != CELL && cdb.src.pileType != TABLEAU) return CS_BAD_MOVE;
+        if (given > 1 && (cdb.src.pileType != TABLEAU || cdb.dst.pileType != TABLEAU)) return CS_BAD_MOVE;
+
+        switch (cdb.dst.pileType)
+        {
+        case FOUNDATION:
+            return fitsFoundation(pSrcPile->topCard(), pDstPile)? CS_OK : CS_BAD_MOVE;
+
+        case CELL:
+            return (pDstPile->getCardCount() == 0)? CS_OK : CS_BAD_MOVE;
+
+        case TABLEAU:
+            if (cdb.src.pileType == CELL) return fitsTableau(pSrcPile->topCard(), pDstPile)? CS_OK : CS_BAD_MOVE;
+
+            // Part of the run given, else the longest movable part that fits
+            run = runLength(pSrcPile);
+            limit = maxRun(pileMap, pDstPile->getCardCount() == 0);
+            if (run > limit) run = limit;
+            if (given != 0)
+            {
+                if (given > run) return CS_BAD_MOVE;
+                cdb.count = given;
+                return fitsTableau(pSrcPile->getCardAt(pSrcPile->getCardCount() - given), pDstPile)? CS_OK : CS_BAD_MOVE;
+            }
+            for (cdb.count = run; cdb.count > 0; cdb.count--)
+            {
+                if (fitsTableau(pSrcPile->getCardAt(pSrcPile->getCardCount() - cdb.count), pDstPile)) return CS_OK;
+            }
+            return CS_BAD_MOVE;
+
+        default:
+            return CS_BAD_MOVE;
+        }
+
+    default:
+        return CS_BAD_CMD;
+    }
+}
+
+// Generate candidate moves in search order; a safe move home, if any, is
+//   returned alone
+inline int FreeCellRules::genMoves(PileMap_t &pileMap, GameMove_t *pMoves)
+{
+    int moveCnt = 0;
+    int firstEmpty = -1;
+    int freeCell = -1;
+    int f;
+
+    for (auto t = 0; t < FREECELL_TABLEAU_COUNT && firstEmpty < 0; t++)
+    {
+        if (PILE(TABLEAU, t)->getCardCount() == 0) firstEmpty = t;
+    }
+    for (auto c = 0; c < FREECELL_CELL_COUNT && freeCell < 0; c++)
+    {
+        if (PILE(CELL, c)->getCardCount() == 0) freeCell = c;
+    }
+
+    // Moves home from cells and tableau; a safe one is played on its own
+    for (auto type : {CELL, TABLEAU})
+    {
+        for (auto i = 0; i < PILE_VECTOR(type).size(); i++)
+        {
+            Card top = PILE(type, i)->topCard();
+            if (top.isNull() || (f = foundationFor(pileMap, top)) < 0) continue;
+            if (isSafeHome(pileMap, top))
+            {
+                moveCnt = 0;
+                FREECELL_ADD_MOVE(type, i, FOUNDATION, f, 1);
+                return moveCnt;
+            }
+            FREECELL_ADD_MOVE(type, i, FOUNDATION, f, 1);
+        }
+    }
+
+    // Runs onto tableau cards; the part of the top run that fits, within the
+    //   move limit, unless it already sits on a card it fits. Moves that
+    //   expose a card able to go home or empty the pile come first.
+    int limit = maxRun(pileMap, false);
+    for (auto pass = 0; pass < 2; pass++)
+    {
+        for (auto s = 0; s < FREECELL_TABLEAU_COUNT; s++)
+        {
+            Pile *pSrcPile = PILE(TABLEAU, s);
+            int cnt = pSrcPile->getCardCount();
+            int fullRun = runLength(pSrcPile);
+            int run = (fullRun > limit)? limit : fullRun;
+            if (cnt == 0) continue;
+
+            for (auto d = 0; d < FREECELL_TABLEAU_COUNT; d++)
+            {
+                Pile *pDstPile = PILE(TABLEAU, d);
+                if (d == s || pDstPile->getCardCount() == 0) continue;
+
+                Card top = pDstPile->topCard();
+                int n = top.getValue() - pSrcPile->topCard().getValue();
+                if (n < 1 || n > run || n < fullRun || !fitsTableau(pSrcPile->getCardAt(cnt - n), pDstPile)) continue;
+
+                Card under = pSrcPile->getCardAt(cnt - n - 1);
+                int movePass = (under.isNull() || foundationFor(pileMap, under) >= 0)? 0 : 1;
+                if (movePass == pass) FREECELL_ADD_MOVE(TABLEAU, s, TABLEAU, d, n);
+            }
+        }
+    }
+
+    // Cells onto tableau cards
+    for (auto c = 0; c < FREECELL_CELL_COUNT; c++)
+    {
+        Card card = PILE(CELL, c)->topCard();
+        if (card.isNull()) continue;
+        for (auto d = 0; d < FREECELL_TABLEAU_COUNT; d++)
+        {
+            Pile *pDstPile = PILE(TABLEAU, d);
+            if (pDstPile->getCardCount() != 0 && fitsTableau(card, pDstPile)) FREECELL_ADD_MOVE(CELL, c, TABLEAU, d, 1);
+        }
+    }
+
+    // To the first empty pile: longest movable run, unless it is the whole pile
+    if (firstEmpty >= 0)
+    {
+        int emptyLimit = maxRun(pileMap, true);
+        for (auto s = 0; s < FREECELL_TABLEAU_COUNT; s++)
+        {
+            Pile *pSrcPile = PILE(TABLEAU, s);
+            int run = runLength(pSrcPile);
+            if (run > emptyLimit) run = emptyLimit;
+            if (run != 0 && run < pSrcPile->getCardCount()) FREECELL_ADD_MOVE(TABLEAU, s, TABLEAU, firstEmpty, run);
+        }
+        for (auto c = 0; c < FREECELL_CELL_COUNT; c++)
+        {
+            if (PILE(CELL, c)->getCardCount() != 0) FREECELL_ADD_MOVE(CELL, c, TABLEAU, firstEmpty, 1);
+        }
+    }
+
+    // Tableau tops to the first free cell; tops over a card able to go home first
+    if (freeCell >= 0)
+    {
+        for (auto pass = 0; pass < 2; pass++)
+        {
+            for (auto s = 0; s < FREECELL_TABLEAU_COUNT; s++)
+            {
+                Pile *pSrcPile = PILE(TABLEAU, s);
+                int cnt = pSrcPile->getCardCount();
+                if (cnt == 0) continue;
+
+                Card under = pSrcPile->getCardAt(cnt - 2);
+                int movePass = (!under.isNull() && foundationFor(pileMap, under) >= 0)? 0 : 1;
+                if (movePass == pass) FREECELL_ADD_MOVE(TABLEAU, s, CELL, freeCell, 1);
+            }
+        }
+    }
+
+    return moveCnt;
+}
+
+// Play generated move
+inline void FreeCellRules::playMove(Game &game, const GameMove_t &move)
+{
+    PileMap_t &pileMap = game.getPileMap();
+
+    game.moveCards(PILE((PileType_t)move.srcType, move.srcId), PILE((PileType_t)move.dstType, move.dstId), move.count);
+}
+
+#endif // FREECELL_RULES_H
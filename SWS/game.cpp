@@ -5,6 +5,34 @@
 using namespace std;
 
 
+// Zobrist key for a card code (including face state) at a pile index and depth;
+//   keys come from a fixed mixing function rather than a stored table, so every
+//   (card, pile, depth) slot has its own key at no memory cost
+static inline quint64 zobristKey(quint8 cardCode, int pileIdx, int depth)
+{
+    quint64 x = ((quint64)cardCode << 24) | ((quint64)pileIdx << 16) | (quint64)depth;
+
+    // SplitMix64 finaliser
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return x ^ (x >> 31);
+}
+
+// Stand-in 'dealStock' for games without a stock deal
+static GameError_t noStockDeal(Game &)
+{
+    return GS_ERROR;
+}
+
+#ifdef SWS_DEBUG_HASH
+#define CHECK_HASH()  Q_ASSERT(checkHash())
+#else
+#define CHECK_HASH()
+#endif
+
+
 ////////////////////////
 // Pile class methods
 
@@ -40,34 +68,119 @@ Pile::Pile(PileType_t pileType, int xLoc, int yLoc)
     cardIt = 0;
 }
 
-// Pop Card ptr from back of vector; if empty return 'nullptr'
-Card * Pile::pop()
+// Pop Card from back of vector; if empty return null card
+Card Pile::pop()
 {
-    Card *pCard;
+    Card card;
 
     if (!pile.empty())
     {
-        pCard = pile.last();
+        card = pile.last();
         pile.pop_back();
     }
-    else pCard = nullptr;
+    else card = Card::nullCard();
 
-    return pCard;
+    return card;
 }
 
-// Pop Card ptr from front of vector; if empty return 'nullptr'
-Card * Pile::popFromFront()
+// Pop Card from front of vector; if empty return null card
+Card Pile::popFromFront()
 {
-    Card *pCard;
+    Card card;
 
     if (!pile.empty())
     {
-        pCard = pile.first();
+        card = pile.first();
         pile.pop_front();
     }
-    else pCard = nullptr;
+    else card = Card::nullCard();
+
+    return card;
+}
+
+// Turn top 'n' cards over onto 'pDstPile' one at a time, as when dealing from
+//   a face-down stock; order is reversed and each card's face is toggled
+void Pile::turnTopTo(Pile *pDstPile, int n)
+{
+    for (auto i = 0; i < n; i++)
+    {
+        Card card = pile.last();
+        pile.pop_back();
+        card.turnOver();
+        pDstPile->pile.push_back(card);
+    }
+}
+
+
+////////////////////////
+// PileTable class methods
+
+PileTable::PileTable()
+{
+    for (auto t = 0; t < INVALID_PILE_TYPE; t++)
+    {
+        first[t] = 0;
+        count[t] = 0;
+    }
+    pileCount = 0;
+    typeCount = 0;
+    typeMask = 0;
+    rebuildIndex();
+}
 
-    return pCard;
+// Append pile to the end of the table; returns 'nullptr' if the table is full
+//   or piles of another type follow the pile's type (see 'canAppend')
+Pile * PileTable::insert(const Pile &newPile)
+{
+    Pile tmp = newPile;
+    PileType_t pileType = tmp.getType();
+
+    if (pileCount == MAX_PILES_PER_TABLE || !canAppend(pileType)) return nullptr;
+
+    // New type's range starts at the end of the table
+    if (!contains(pileType))
+    {
+        first[pileType] = pileCount;
+        typeMask |= (1 << pileType);
+        typeCount++;
+    }
+
+    piles[pileCount] = tmp;
+    count[pileType]++;
+
+    return &piles[pileCount++];
+}
+
+// Rebuild card location index from every pile; index is dropped if any card
+//   is repeated or not part of a standard deck
+void PileTable::rebuildIndex()
+{
+    indexed = false;
+    tableMask = 0;
+    faceUpMask = 0;
+    for (auto t = 0; t < INVALID_PILE_TYPE; t++) cardMask[t] = 0;
+    for (auto &loc : cardLoc)
+    {
+        loc.pile = CARD_LOC_NONE;
+        loc.depth = 0;
+    }
+
+    for (auto idx = 0; idx < pileCount; idx++)
+    {
+        Pile *pPile = &piles[idx];
+        for (auto depth = 0; depth < pPile->getCardCount(); depth++)
+        {
+            Card card = pPile->getCardAt(depth);
+            if (card.getValue() < ACE || card.getValue() > KING || (tableMask & CARD_BIT(card))) return;
+
+            tableMask |= CARD_BIT(card);
+            cardMask[pPile->getType()] |= CARD_BIT(card);
+            if (card.isFaceUp()) faceUpMask |= CARD_BIT(card);
+            cardLoc[CARD_INDEX(card)].pile = (quint8)idx;
+            cardLoc[CARD_INDEX(card)].depth = (quint8)depth;
+        }
+    }
+    indexed = true;
 }
 
 
@@ -77,56 +190,99 @@ Card * Pile::popFromFront()
 // Init Game object
 Game::Game(DeckType_t deckType,
            void (*checkForWinFunc)(PileMap_t &pileMap, GameState_t &state),
-           CmdError_t (*validateCommandFunc)(Cdb_t &cdb),
-           uint gameSeed) : deck(deckType)
+           CmdError_t (*validateCommandFunc)(PileMap_t &pileMap, Cdb_t &cdb),
+           uint gameSeed,
+           DealVersion_t gameDealVersion,
+           int deckCount,
+           GameError_t (*dealStockFunc)(Game &game)) : deck(deckType, deckCount)
 {
     state = GAME_IN_PROGRESS;
+    winPending = false;
 
     // Assign function pointers
-    checkForWin = checkForWinFunc;
-    validateCommand = validateCommandFunc;
+    ruleFuncs.checkForWin = checkForWinFunc;
+    ruleFuncs.validateCommand = validateCommandFunc;
+    ruleFuncs.dealStock = (dealStockFunc != nullptr)? dealStockFunc : noStockDeal;
 
     // Deck will have been instantiated; shuffle here and record seed
-    deckSeed = deck.shuffle(gameSeed);
+    dealVersion = gameDealVersion;
+    deckSeed = deck.shuffle(gameSeed, dealVersion);
+
+    hash = 0;
+    cardCount = 0;
+    cardsHome = 0;
+    journalCap = JOURNAL_INITIAL_ENTRIES;
+    journal = arena.allocArray<MoveDelta_t>(journalCap);
+    journalSize = 0;
+    journalPos = 0;
+    stepLen = -1;
+    dirtyPiles = PILE_MASK_ALL;
+
+    openPileType = TABLEAU;
+    openMethod = INCREMENTING;
+    openCount = -1;
+}
+
+// Copy Game object; history is copied into the new game's own arena
+Game::Game(const Game &other)
+    : state(other.state), winPending(other.winPending), pileMap(other.pileMap), deck(other.deck), deckSeed(other.deckSeed),
+      dealVersion(other.dealVersion), hash(other.hash), cardCount(other.cardCount), cardsHome(other.cardsHome),
+      journalSize(other.journalSize), journalCap(other.journalCap), journalPos(other.journalPos),
+      stepLen(other.stepLen), dirtyPiles(other.dirtyPiles), openPileType(other.openPileType),
+      openMethod(other.openMethod), openCount(other.openCount), ruleFuncs(other.ruleFuncs)
+{
+    journal = arena.allocArray<MoveDelta_t>(journalCap);
+    memcpy(journal, other.journal, journalSize * sizeof(MoveDelta_t));
 }
 
-// Register pile with game
-void Game::registerPile(PileType_t pileType, int pileCount, int xLoc, int yLoc)
+// Register piles with game; nothing is registered if the table has no room for
+//   them all ('GS_PILE_FULL') or the type cannot be added to ('GS_ERROR')
+GameError_t Game::registerPile(PileType_t pileType, int pileCount, int xLoc, int yLoc)
 {
     int x = xLoc;
     int y = yLoc;
     bool newPileVec = (PILE_MAP.contains(pileType) == false);
 
-    // Add pile set vector if not already created
-    if (newPileVec)
-    {
-        PILE_MAP.insert(pileType, {});
-    }
+    if (pileCount < 1 || !PILE_MAP.canAppend(pileType)) return GS_ERROR;
+    if (PILE_MAP.getPileCount() + pileCount > MAX_PILES_PER_TABLE) return GS_PILE_FULL;
 
-    // Create empty pile vectors
-    for (auto p = 0; p < pileCount; p++)
-    {
-        Pile *pNewPile = new Pile(pileType, x++, y);
-        PILE_VECTOR(pileType).insert(PILE_VECTOR(pileType).end(), pNewPile);
-    }
+    // Lay out empty piles in table
+    for (auto p = 0; p < pileCount; p++) PILE_MAP.insert(Pile(pileType, x++, y));
 
     // If registering DECK, init with cards
-    if ((pileType == DECK) && newPileVec)
+    if ((pileType == DECK) && newPileVec && PILE_MAP.contains(DECK))
     {
-        for (auto pCard : deck.getCardList())
+        for (auto card : deck)
         {
-            PILE_DECK->push(pCard);
+            PILE_DECK->push(card);
         }
     }
+
+    // Rekey whole table and drop history
+    resync();
+
+    return GS_OK;
 }
 
-// Deal cards to piles as specified; returns 'true' if no cards to deal
-GameError_t Game::deal(PileType_t pileType, DealMethod_t dealMethod)
+// Deal cards to piles as specified; 'dealCount' limits an 'ALL' deal ('0' for
+//   whole deck)
+GameError_t Game::deal(PileType_t pileType, DealMethod_t dealMethod, int dealCount)
 {
     GameError_t status = GS_ERROR;
+    int pileCnt = PILE_MAP.contains(pileType)? PILE_VECTOR(pileType).size() : 0;
 
+    if (pileCnt == 0) return GS_ERROR; // No piles of that type to deal to
     if (PILE_DECK->getCardCount() == 0) return GS_EMPTY_PILE;
 
+    // Deal from a full deck is the opening deal
+    if (PILE_DECK->getCardCount() == deck.getCardCount())
+    {
+        openPileType = pileType;
+        openMethod = dealMethod;
+        openCount = dealCount;
+    }
+    if (dealCount <= 0 || dealCount > PILE_DECK->getCardCount()) dealCount = PILE_DECK->getCardCount();
+
     switch (dealMethod)
     {
     case SINGLE:
@@ -134,7 +290,7 @@ GameError_t Game::deal(PileType_t pileType, DealMethod_t dealMethod)
         {
             status = moveCard(PILE_DECK, pPile);
             if (status != GS_OK) goto deal_error;
-            pPile->topCard()->flipFaceUp();
+            flipTopCard(pPile);
         }
         break;
 
@@ -145,86 +301,313 @@ GameError_t Game::deal(PileType_t pileType, DealMethod_t dealMethod)
             {
                 status = moveCard(PILE_DECK, PILE(pileType, j));
                 if (status != GS_OK) goto deal_error;
-                if (i == j) PILE(pileType, j)->topCard()->flipFaceUp();
+                if (i == j) flipTopCard(PILE(pileType, j));
             }
         }
         break;
 
     case DECREMENTING:
-        for (auto i = PILE_VECTOR(pileType).size(); i >= 0; i--)
+        // Round 'i' deals to piles '0' to 'i - 1'; last card of each pile face up
+        for (auto i = pileCnt; i > 0; i--)
         {
             for (auto j = 0; j < i; j++)
             {
                 status = moveCard(PILE_DECK, PILE(pileType, j));
                 if (status != GS_OK) goto deal_error;
-                if (j == (i - 1)) PILE(pileType, j)->topCard()->flipFaceUp();
             }
+            flipTopCard(PILE(pileType, i - 1));
         }
         break;
 
     case ALL:
-        while (PILE_DECK->getCardCount() != 0)
+    case ALL_FACE_UP:
+        // Deck may run out part way round
+        status = GS_OK;
+        for (auto i = 0; i < dealCount; i++)
         {
-            for (auto pPile : PILE_VECTOR(pileType))
-            {
-                status = moveCard(PILE_DECK, pPile);
-                if (status != GS_OK) goto deal_error;
-            }
+            Pile *pPile = PILE(pileType, i % pileCnt);
+            status = moveCard(PILE_DECK, pPile);
+            if (status != GS_OK) goto deal_error;
+            if (dealMethod == ALL_FACE_UP) flipTopCard(pPile);
         }
-        for (auto pPile : PILE_VECTOR(pileType))
+        if (dealMethod == ALL)
         {
-            pPile->topCard()->flipFaceUp();
+            for (auto pPile : PILE_VECTOR(pileType)) flipTopCard(pPile);
         }
         break;
     }
 
 deal_error:
+    clearJournal(); // Opening deal cannot be undone
     return status;
 }
 
-// Move card(s) from one pile to another
+// Start a new game on the registered piles: every card back to the deck,
+//   reshuffled from 'gameSeed' and dealt as the opening deal was; the journal
+//   is re-carved from the blocks the arena already holds, so no memory is
+//   allocated
+GameError_t Game::reset(uint gameSeed)
+{
+    for (auto pPile : PILE_MAP) pPile->clear();
+    deck.reset();
+    deckSeed = deck.shuffle(gameSeed, dealVersion);
+    if (PILE_MAP.contains(DECK))
+    {
+        for (auto card : deck) PILE_DECK->push(card);
+    }
+
+    state = GAME_IN_PROGRESS;
+    resync();
+    if (openCount < 0 || !PILE_MAP.contains(DECK)) return GS_OK;
+
+    return deal(openPileType, openMethod, openCount);
+}
+
+// Move top 'n' card(s) from one pile to another as a single block; order
+//   within the block is preserved
 GameError_t Game::moveCards(Pile *pSrcPile, Pile *pDstPile, int n)
 {
-    Card **pCard;
+    if (n < 1) return GS_ERROR;
+
+    // Check card count of source pile and room in destination pile
+    if (pSrcPile->getCardCount() == 0) return GS_EMPTY_PILE;
+    if (pSrcPile->getCardCount() < n) return GS_INS_PILE_SIZE;
+    if (pDstPile->getCardCount() + n > Pile_t::capacity()) return GS_PILE_FULL;
+
+    shiftCards(pSrcPile, pDstPile, n);
+    record(pSrcPile, pDstPile, n, 0);
+
+    return GS_OK;
+}
+
+// Turn top 'n' card(s) of one pile over onto another (e.g. stock draw or
+//   waste recycle)
+GameError_t Game::turnCards(Pile *pSrcPile, Pile *pDstPile, int n)
+{
+    if (n < 1) return GS_ERROR;
 
-    // Check card count of source pile
     if (pSrcPile->getCardCount() == 0) return GS_EMPTY_PILE;
     if (pSrcPile->getCardCount() < n) return GS_INS_PILE_SIZE;
+    if (pDstPile->getCardCount() + n > Pile_t::capacity()) return GS_PILE_FULL;
+
+    turnOver(pSrcPile, pDstPile, n);
+    record(pSrcPile, pDstPile, n, MD_TURN);
+
+    return GS_OK;
+}
+
+// Set face state of a pile's top card; journaled only if the card turns
+GameError_t Game::flipTopCard(Pile *pPile, CardState_t cardState)
+{
+    if (pPile->getCardCount() == 0) return GS_EMPTY_PILE;
+    if (pPile->topCard().isFaceUp() == (cardState == FACE_UP)) return GS_OK;
+
+    toggleTopCard(pPile);
+    record(pPile, pPile, 0, MD_FLIP);
+
+    return GS_OK;
+}
+
+// Take back what the open step has done so far and close it; for a step that
+//   fails part way
+void Game::cancelStep()
+{
+    if (stepLen > 0)
+    {
+        while (stepLen-- > 0) replay(journal[--journalPos], false);
+        journalSize = journalPos;
+    }
+    stepLen = -1;
+}
+
+// Revert last step in journal
+GameError_t Game::undo()
+{
+    bool linked;
+
+    if (journalPos == 0) return GS_NO_HISTORY;
+
+    do
+    {
+        const MoveDelta_t &delta = journal[--journalPos];
+        replay(delta, false);
+        linked = (delta.flags & MD_LINKED) != 0;
+    } while (linked && journalPos != 0);
+    if (state == GAME_OVER) state = GAME_IN_PROGRESS; // Re-detected by rules
+
+    return GS_OK;
+}
+
+// Replay next undone step in journal
+GameError_t Game::redo()
+{
+    if (journalPos == journalSize) return GS_NO_HISTORY;
+
+    do
+    {
+        replay(journal[journalPos++], true);
+    } while (journalPos != journalSize && (journal[journalPos].flags & MD_LINKED));
+    if (state == GAME_OVER) state = GAME_IN_PROGRESS; // Re-detected by rules
 
-    pCard = new Card * [n];
+    return GS_OK;
+}
 
-    // Pull from srcPile
+// Drop all undo/redo history; blocks outgrown by the journal are reclaimed by
+//   clearing the arena and carving it again at its current capacity
+void Game::clearJournal()
+{
+    arena.clear();
+    journal = arena.allocArray<MoveDelta_t>(journalCap);
+    journalSize = 0;
+    journalPos = 0;
+}
+
+// Move journal to an arena block twice the size; the old block is dead until
+//   the next 'clearJournal'
+void Game::growJournal()
+{
+    MoveDelta_t *pOld = journal;
+
+    journalCap *= 2;
+    journal = arena.allocArray<MoveDelta_t>(journalCap);
+    memcpy(journal, pOld, journalPos * sizeof(MoveDelta_t));
+}
+
+// Block move with hash upkeep; no checks, no journaling
+void Game::shiftCards(Pile *pSrcPile, Pile *pDstPile, int n)
+{
+    int srcIdx = PILE_MAP.indexOf(pSrcPile);
+    int dstIdx = PILE_MAP.indexOf(pDstPile);
+    int srcDepth = pSrcPile->getCardCount() - n;
+    int dstDepth = pDstPile->getCardCount();
+
+    pSrcPile->moveTopTo(pDstPile, n);
+    dirtyPiles |= PILE_BIT(srcIdx) | PILE_BIT(dstIdx);
+
+    // Re-key and re-index moved cards at their new pile and depth
     for (auto i = 0; i < n; i++)
     {
-        pCard[i] = pSrcPile->popFromFront();
+        Card card = pDstPile->getCardAt(dstDepth + i);
+        hash ^= zobristKey(card.getCode(), srcIdx, srcDepth + i) ^ zobristKey(card.getCode(), dstIdx, dstDepth + i);
+        PILE_MAP.placeCard(card, dstIdx, dstDepth + i);
     }
+    countHome(pSrcPile, pDstPile, n); // Rules may look at the index
+    CHECK_HASH();
+}
 
-    // Push to dstPile
+// Turn-over move with hash upkeep; no checks, no journaling
+void Game::turnOver(Pile *pSrcPile, Pile *pDstPile, int n)
+{
+    int srcIdx = PILE_MAP.indexOf(pSrcPile);
+    int dstIdx = PILE_MAP.indexOf(pDstPile);
+    int srcDepth = pSrcPile->getCardCount() - n;
+    int dstDepth = pDstPile->getCardCount();
+
+    // Cards change face and position, so un-key before and re-key after
+    for (auto i = 0; i < n; i++) hash ^= zobristKey(pSrcPile->getCardAt(srcDepth + i).getCode(), srcIdx, srcDepth + i);
+    pSrcPile->turnTopTo(pDstPile, n);
+    dirtyPiles |= PILE_BIT(srcIdx) | PILE_BIT(dstIdx);
     for (auto i = 0; i < n; i++)
     {
-        pDstPile->push(pCard[i]);
+        Card card = pDstPile->getCardAt(dstDepth + i);
+        hash ^= zobristKey(card.getCode(), dstIdx, dstDepth + i);
+        PILE_MAP.placeCard(card, dstIdx, dstDepth + i);
     }
+    countHome(pSrcPile, pDstPile, n);
+    CHECK_HASH();
+}
 
-    return GS_OK;
+// Toggle top card face with hash upkeep; pile must not be empty
+void Game::toggleTopCard(Pile *pPile)
+{
+    int pileIdx = PILE_MAP.indexOf(pPile);
+    int depth = pPile->getCardCount() - 1;
+    quint8 oldCode = pPile->getCardAt(depth).getCode();
+
+    pPile->flipTopCard(pPile->getCardAt(depth).isFaceUp()? FACE_DOWN : FACE_UP);
+    dirtyPiles |= PILE_BIT(pileIdx);
+    hash ^= zobristKey(oldCode, pileIdx, depth) ^ zobristKey(pPile->getCardAt(depth).getCode(), pileIdx, depth);
+    PILE_MAP.placeCard(pPile->getCardAt(depth), pileIdx, depth);
+    CHECK_HASH();
 }
 
-// Print game table
-void Game::print(GameConsole &console)
+// Append change to journal, discarding any redoable entries
+void Game::record(Pile *pSrcPile, Pile *pDstPile, int n, quint8 flags)
 {
-    console.printTable(pileMap);
+    MoveDelta_t delta;
+
+    // Entries after the first of an open step undo with it
+    if (stepLen > 0) flags |= MD_LINKED;
+    if (stepLen >= 0) stepLen++;
+
+    delta.src = (quint8)PILE_MAP.indexOf(pSrcPile);
+    delta.dst = (quint8)PILE_MAP.indexOf(pDstPile);
+    delta.count = (quint8)n;
+    delta.flags = flags;
+
+    if (journalPos == journalCap) growJournal();
+    journal[journalPos++] = delta;
+    journalSize = journalPos;
 }
 
-// Process command in CDB
-CmdError_t Game::processCommand(Cdb_t &cdb)
+// Apply journal entry forwards (redo) or backwards (undo)
+void Game::replay(const MoveDelta_t &delta, bool forward)
 {
-    CmdError_t status = validateCommand(cdb);
+    Pile *pSrcPile = PILE_MAP.at(forward? delta.src : delta.dst);
+    Pile *pDstPile = PILE_MAP.at(forward? delta.dst : delta.src);
+
+    if (delta.flags & MD_FLIP) toggleTopCard(pSrcPile);
+    else if (delta.flags & MD_TURN) turnOver(pSrcPile, pDstPile, delta.count);
+    else shiftCards(pSrcPile, pDstPile, delta.count);
+}
 
-    if (status == CS_OK)
+// Recompute Zobrist hash from every card on table
+quint64 Game::computeHash()
+{
+    quint64 h = 0;
+    int pileIdx = 0;
+
+    for (auto pPile : PILE_MAP)
     {
-        // Command is valid; execute
+        for (auto depth = 0; depth < pPile->getCardCount(); depth++)
+        {
+            h ^= zobristKey(pPile->getCardAt(depth).getCode(), pileIdx, depth);
+        }
+        pileIdx++;
     }
 
-    return status;
+    return h;
+}
+
+// Recompute everything derived from the piles and drop history
+void Game::resync()
+{
+    rehash();
+    PILE_MAP.rebuildIndex();
+    clearJournal();
+    markAllDirty();
+
+    // Recount cards home
+    cardCount = 0;
+    cardsHome = 0;
+    for (auto pPile : PILE_MAP)
+    {
+        cardCount += pPile->getCardCount();
+        if (pPile->getType() == FOUNDATION) cardsHome += pPile->getCardCount();
+    }
+    winPending = false;
+    if (state == GAME_WON || state == GAME_IN_PROGRESS)
+    {
+        state = GAME_IN_PROGRESS;
+        winPending = (cardCount != 0 && cardsHome == cardCount);
+    }
+}
+
+// Print game table
+void Game::print(GameConsole &console)
+{
+    console.printTable(pileMap, dirtyPiles);
+    dirtyPiles = 0;
 }
 
 
@@ -248,3 +631,48 @@ const QCommandLineOption & SetGameAppInfo(const QString &name, const QString &ve
 
     return seedOpt;
 }
+
+// Add deal generator version option
+const QCommandLineOption & AddDealVersionOption(QCommandLineParser &parser)
+{
+    static const QCommandLineOption dealOpt(QStringList() << "deal-version",
+        QCoreApplication::translate("main", "Set deal generator version (0 for legacy)."),
+        QCoreApplication::translate("main", "version"));
+    parser.addOption(dealOpt);
+
+    return dealOpt;
+}
+
+// Get deal generator version from parsed options; current version if unset,
+//   'INVALID_DEAL_VERSION' if not a known version
+DealVersion_t GetDealVersion(const QCommandLineParser &parser, const QCommandLineOption &dealOpt)
+{
+    bool ok;
+    int version;
+
+    if (!parser.isSet(dealOpt)) return DEAL_CURRENT;
+
+    version = parser.value(dealOpt).toInt(&ok);
+    if (!ok || version < 0 || version >= DEAL_VERSION_COUNT) return INVALID_DEAL_VERSION;
+
+    return (DealVersion_t)version;
+}
+
+// Add table render mode option
+const QCommandLineOption & AddRenderModeOption(QCommandLineParser &parser)
+{
+    static const QCommandLineOption renderOpt(QStringList() << "r" << "render",
+        QCoreApplication::translate("main", "Set table render mode: 'full' or 'diff' (changed cells only)."),
+        QCoreApplication::translate("main", "mode"));
+    parser.addOption(renderOpt);
+
+    return renderOpt;
+}
+
+// Get table render mode from parsed options; full redraw if unset or invalid
+RenderMode_t GetRenderMode(const QCommandLineParser &parser, const QCommandLineOption &renderOpt)
+{
+    if (parser.isSet(renderOpt) && parser.value(renderOpt).toLower() == "diff") return RENDER_DIFF;
+
+    return RENDER_FULL;
+}
@@ -1,36 +1,45 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include <QMap>
 #include <QVector>
 #include <QCommandLineParser>
 #include "game_common.h"
 #include "console.h"
 #include "command.h"
+#include "game_arena.h"
 
 
 // Game pile class
 class Pile
 {
 public:
-    Pile(PileType_t pileType, int xLoc, int yLoc);
+    Pile(PileType_t pileType = INVALID_PILE_TYPE, int xLoc = 0, int yLoc = 0);
 
     inline int getCardCount()  { return pile.size(); }
 
     inline PilePrintStyle_t getPrintStyle()  { return printStyle; }
 
+    inline PileType_t getType()  { return type; }
+
     inline void getCoord(int *pX, int *pY)  { *pX = loc.x; *pY = loc.y; }
 
-    inline Card * getCard(int offset = 0)  { return pile.value(cardIt + offset, nullptr); }
-    inline Card * nextCard()  { return pile.value(--cardIt, nullptr); }
-    inline Card * prevCard()  { return pile.value(++cardIt, nullptr); }
-    inline Card * topCard()     { cardIt = pile.size() - 1; return getCard(); }
-    inline Card * bottomCard()  { cardIt = 0; return getCard(); }
+    inline Card getCard(int offset = 0)  { return pile.value(cardIt + offset, Card::nullCard()); }
+    inline Card nextCard()  { return pile.value(--cardIt, Card::nullCard()); }
+    inline Card prevCard()  { return pile.value(++cardIt, Card::nullCard()); }
+    inline Card topCard()     { cardIt = pile.size() - 1; return getCard(); }
+    inline Card bottomCard()  { cardIt = 0; return getCard(); }
+    inline Card getCardAt(int idx)  { return pile.value(idx, Card::nullCard()); }
+
+    inline void flipTopCard(CardState_t cardState = FACE_UP);
+
+    inline void push(Card newCard)  { pile.push_back(newCard); }
+    Card pop();
+    inline void pushToFront(Card newCard)  { pile.push_front(newCard); }
+    Card popFromFront();
 
-    inline void push(Card *pNewCard)  { pile.push_back(pNewCard); }
-    Card * pop();
-    inline void pushToFront(Card *pNewCard)  { pile.push_front(pNewCard); }
-    Card * popFromFront();
+    inline void moveTopTo(Pile *pDstPile, int n)  { pile.spliceTo(pDstPile->pile, n); }
+    void turnTopTo(Pile *pDstPile, int n);
+    inline void clear()  { pile.clear(); cardIt = 0; }
 
 private:
     Pile_t pile;
@@ -40,6 +49,149 @@ private:
     int cardIt;
 };
 
+// Set face state of top card; no effect on empty pile
+inline void Pile::flipTopCard(CardState_t cardState)
+{
+    if (pile.empty()) return;
+
+    if (cardState == FACE_UP) pile.last().flipFaceUp();
+    else pile.last().flipFaceDown();
+}
+
+
+// Iterator yielding pile pointers over contiguous pile storage
+class PileIterator
+{
+public:
+    PileIterator(Pile *pPile) : pCur(pPile) {}
+
+    inline Pile * operator*() const  { return pCur; }
+    inline PileIterator & operator++()  { pCur++; return *this; }
+    inline bool operator!=(const PileIterator &other) const  { return pCur != other.pCur; }
+
+private:
+    Pile *pCur;
+};
+
+// View of all piles of a single type
+class PileVector
+{
+public:
+    PileVector(Pile *pFirstPile = nullptr, int pileCount = 0) : pFirst(pFirstPile), count(pileCount) {}
+
+    inline int size() const  { return count; }
+    inline Pile * operator[](int pid) const  { return pFirst + pid; }
+
+    inline PileIterator begin() const  { return PileIterator(pFirst); }
+    inline PileIterator end() const    { return PileIterator(pFirst + count); }
+
+private:
+    Pile *pFirst;
+    int count;
+};
+
+// Flat table of all piles in registration order, each type's piles together;
+//   iterating the table visits every pile. Piles never move once registered,
+//   so pile pointers and indices stay valid for the life of the table
+/* The table also carries a card location index: a card mask per pile type, a
+ * mask of face-up cards and each card's pile and depth. 'Game' keeps it current
+ * as cards move, so rule queries are mask operations rather than pile scans.
+ * The index only exists while every card on table is unique (at most one
+ * standard deck); 'isIndexed()' is 'false' otherwise and the queries must not
+ * be used. */
+class PileTable
+{
+public:
+    PileTable();
+
+    inline int size() const  { return typeCount; }  // Number of registered pile types
+    inline bool contains(PileType_t pileType) const  { return (typeMask & (1 << pileType)) != 0; }
+    inline bool contains(PileType_t pileType, int pid) const
+        { return contains(pileType) && pid >= 0 && pid < count[pileType]; }
+    inline int getPileCount() const  { return pileCount; }
+    inline bool canAppend(PileType_t pileType) const  // New type, or the last one registered
+        { return IS_VALID_PILE_TYPE(pileType) && (!contains(pileType) || first[pileType] + count[pileType] == pileCount); }
+
+    inline PileVector operator[](PileType_t pileType)
+        { return PileVector(&piles[first[pileType]], count[pileType]); }
+    inline Pile * getPile(PileType_t pileType, int pid)  { return &piles[first[pileType] + pid]; }
+    inline Pile * at(int idx)  { return &piles[idx]; }
+    inline int indexOf(const Pile *pPile) const  { return (int)(pPile - piles); }
+
+    inline PileIterator begin()  { return PileIterator(piles); }
+    inline PileIterator end()    { return PileIterator(piles + pileCount); }
+
+    Pile * insert(const Pile &newPile);
+
+    inline bool isIndexed() const  { return indexed; }
+    inline CardMask_t getCardMask(PileType_t pileType) const  { return cardMask[pileType]; }
+    inline CardMask_t getFaceUpMask() const  { return faceUpMask; }
+    inline CardMask_t getTableMask() const   { return tableMask; }  // Every card on table
+    inline CardLoc_t locate(Card card) const  { return cardLoc[CARD_INDEX(card)]; }
+    inline bool isCardIn(Card card, PileType_t pileType) const  { return (cardMask[pileType] & CARD_BIT(card)) != 0; }
+
+    inline void placeCard(Card card, int pileIdx, int depth);
+    void rebuildIndex();
+
+private:
+    Pile piles[MAX_PILES_PER_TABLE];
+    int first[INVALID_PILE_TYPE];
+    int count[INVALID_PILE_TYPE];
+    int pileCount;
+    int typeCount;
+    unsigned typeMask;
+
+    bool indexed;
+    CardMask_t cardMask[INVALID_PILE_TYPE];  // Cards per pile type
+    CardMask_t faceUpMask;
+    CardMask_t tableMask;
+    CardLoc_t cardLoc[CARDS_PER_STD_DECK];   // By 'CARD_INDEX'
+};
+
+// Record card's new pile, depth and face state in the index
+inline void PileTable::placeCard(Card card, int pileIdx, int depth)
+{
+    if (!indexed) return;
+
+    CardMask_t bit = CARD_BIT(card);
+    CardLoc_t &loc = cardLoc[CARD_INDEX(card)];
+
+    if (loc.pile != CARD_LOC_NONE) cardMask[piles[loc.pile].getType()] &= ~bit;
+    cardMask[piles[pileIdx].getType()] |= bit;
+    if (card.isFaceUp()) faceUpMask |= bit;
+    else faceUpMask &= ~bit;
+    loc.pile = (quint8)pileIdx;
+    loc.depth = (quint8)depth;
+}
+
+
+// Journal entry flags
+#define MD_FLIP    (0x01)  // Top card of 'src' pile turned; 'dst' and 'count' unused
+#define MD_TURN    (0x02)  // Cards turned over as a block; order reversed and faces toggled
+#define MD_LINKED  (0x04)  // Undone/redone together with the previous entry
+
+#define JOURNAL_INITIAL_ENTRIES  (128)  // Journal capacity of a new game; doubled as needed
+
+// Journaled table change; replayed forwards for redo and inverted for undo
+typedef struct _MoveDelta_t
+{
+    quint8 src;    // Source pile table index
+    quint8 dst;    // Destination pile table index
+    quint8 count;  // Card count
+    quint8 flags;  // 'MD_' flags
+} MoveDelta_t;
+
+
+class Game;
+
+// Rules given at run time as function pointers
+typedef struct _RuleFuncs_t
+{
+    void (*checkForWin)(PileMap_t &pileMap, GameState_t &state);
+    CmdError_t (*validateCommand)(PileMap_t &pileMap, Cdb_t &cdb);
+    GameError_t (*dealStock)(Game &game);  // 'deal' command, once validated
+} RuleFuncs_t;
+
 
 // Standard game control class
 class Game
@@ -47,37 +199,245 @@ class Game
 public:
     Game(DeckType_t deckType,
          void (*checkForWinFunc)(PileMap_t &pileMap, GameState_t &state),
-         CmdError_t (*validateCommandFunc)(Cdb_t &cdb),
-         uint gameSeed = INVALID_SEED);
+         CmdError_t (*validateCommandFunc)(PileMap_t &pileMap, Cdb_t &cdb),
+         uint gameSeed = INVALID_SEED,
+         DealVersion_t gameDealVersion = DEAL_CURRENT,
+         int deckCount = 1,
+         GameError_t (*dealStockFunc)(Game &game) = nullptr);  // 'nullptr' if the game has no stock deal
+    Game(const Game &other);  // Copy has its own arena
+    Game & operator=(const Game &) = delete;
 
-    inline bool isGameFinished()  { return (state == GAME_WON || state == GAME_OVER); }
-    inline bool isGameWon()       { return (state == GAME_WON); }
+    inline bool isGameFinished()  { settleWin(ruleFuncs); return (state == GAME_WON || state == GAME_OVER); }
+    inline bool isGameWon()       { settleWin(ruleFuncs); return (state == GAME_WON); }
+    inline GameState_t getState()  { settleWin(ruleFuncs); return state; }
+    inline int getCardsHome() const  { return cardsHome; }
+    inline int getCardCount() const  { return cardCount; }
 
-    void registerPile(PileType_t pileType, int pileCount, int xLoc, int yLoc);
+    GameError_t registerPile(PileType_t pileType, int pileCount, int xLoc, int yLoc);
 
-    GameError_t deal(PileType_t pileType = TABLEAU, DealMethod_t dealMethod = INCREMENTING);
+    GameError_t deal(PileType_t pileType = TABLEAU, DealMethod_t dealMethod = INCREMENTING, int dealCount = 0);
+    GameError_t reset(uint gameSeed = INVALID_SEED);
     GameError_t moveCards(Pile *pSrcPile, Pile *pDstPile, int n);
     inline GameError_t moveCard(Pile *pSrcPile, Pile *pDstPile)  { return moveCards(pSrcPile, pDstPile, 1); }
+    GameError_t turnCards(Pile *pSrcPile, Pile *pDstPile, int n);
+    GameError_t flipTopCard(Pile *pPile, CardState_t cardState = FACE_UP);
+
+    inline void beginStep()  { stepLen = 0; }
+    inline void endStep()    { stepLen = -1; }
+    void cancelStep();
+    GameError_t undo();
+    GameError_t redo();
+    inline bool canUndo() const  { return journalPos != 0; }
+    inline bool canRedo() const  { return journalPos != journalSize; }
+    inline int getJournalSize() const  { return journalSize; }
+    inline int getJournalPos() const  { return journalPos; }  // Entries done; an empty step adds none
+    void clearJournal();
+
+    inline size_t getArenaBytes() const  { return arena.getReservedBytes(); }
 
-    CmdError_t processCommand(Cdb_t &cdb);
+    inline CmdError_t processCommand(Cdb_t &cdb)  { return dispatchCommand(cdb, ruleFuncs); }
 
     void print(GameConsole &console);
 
+    inline PileMap_t & getPileMap()  { return pileMap; }
+
     inline uint getDeckSeed()  { return deckSeed; }
+    inline DealVersion_t getDealVersion()  { return dealVersion; }
+
+    inline quint64 getHash() const  { return hash; }
+    quint64 computeHash();
+    inline bool checkHash()  { return hash == computeHash(); }
+    inline void rehash()     { hash = computeHash(); }
+
+    inline quint32 getDirtyPiles() const  { return dirtyPiles; }
+    inline void markAllDirty()  { dirtyPiles = PILE_MASK_ALL; }
+    void resync();  // After piles are changed outside 'Game'
+
+protected:
+    template <class Rules>
+    CmdError_t dispatchCommand(Cdb_t &cdb, const Rules &rules);
+    template <class Rules>
+    inline void settleWin(const Rules &rules);
 
 private:
     GameState_t state;
+    bool winPending;  // Last card went home since the rules last looked
     PileMap_t pileMap;
     Deck deck;
     uint deckSeed;
+    DealVersion_t dealVersion;
+    quint64 hash;  // Zobrist hash of all cards on table
+    int cardCount;  // Cards on table
+    int cardsHome;  // Cards on foundations; all of them home wins
+    GameArena arena;  // Journal storage; cleared for reuse, freed with the game
+    MoveDelta_t *journal;  // Undo/redo history; entries past 'journalPos' are redoable
+    int journalSize;
+    int journalCap;
+    int journalPos;
+    int stepLen;  // Entries recorded in the open step; '-1' if none open
+    quint32 dirtyPiles;  // Piles changed since last print, by table index
+
+    // Opening deal, repeated by 'reset'; 'openCount' is '-1' until one is made
+    PileType_t openPileType;
+    DealMethod_t openMethod;
+    int openCount;
+
+    inline void countHome(Pile *pSrcPile, Pile *pDstPile, int n);
+    void shiftCards(Pile *pSrcPile, Pile *pDstPile, int n);
+    void turnOver(Pile *pSrcPile, Pile *pDstPile, int n);
+    void toggleTopCard(Pile *pPile);
+    void record(Pile *pSrcPile, Pile *pDstPile, int n, quint8 flags);
+    void growJournal();
+    void replay(const MoveDelta_t &delta, bool forward);
 
     // Undefined functions
-    void (*checkForWin)(PileMap_t &pileMap, GameState_t &state);
-    CmdError_t (*validateCommand)(Cdb_t &cdb);
+    RuleFuncs_t ruleFuncs;
+};
+
+
+// Track cards moved on or off foundations; once the last card goes home the
+//   rules are asked for a win when the state is next read, and a won game is
+//   no longer won once one leaves
+inline void Game::countHome(Pile *pSrcPile, Pile *pDstPile, int n)
+{
+    if (pSrcPile->getType() == FOUNDATION)
+    {
+        cardsHome -= n;
+        winPending = false;
+        if (state == GAME_WON) state = GAME_IN_PROGRESS;
+    }
+    if (pDstPile->getType() == FOUNDATION)
+    {
+        cardsHome += n;
+        if (cardCount != 0 && cardsHome == cardCount) winPending = true;
+    }
+}
+
+// Ask the rules for a win if all cards went home since they last looked;
+//   'rules' is as for 'dispatchCommand'
+template <class Rules>
+inline void Game::settleWin(const Rules &rules)
+{
+    if (!winPending) return;
+    winPending = false;
+    rules.checkForWin(pileMap, state);
+}
+
+// Process command in CDB; a valid move, flip or deal is executed as a single
+//   undo step
+/* 'rules' is anything with 'checkForWin', 'validateCommand' and 'dealStock'
+ * callable as in 'RuleFuncs_t': the run-time pointers, or a rules class whose
+ * static members are then called directly. */
+template <class Rules>
+CmdError_t Game::dispatchCommand(Cdb_t &cdb, const Rules &rules)
+{
+    CmdError_t status;
+    GameError_t gameStatus = GS_OK;
+    Pile *pSrcPile;
+    Pile *pDstPile;
+
+    // History commands are common to all games
+    switch (cdb.cmdId)
+    {
+    case _UNDO_CMD:
+    case _REDO_CMD:
+        gameStatus = (cdb.cmdId == _UNDO_CMD)? undo() : redo();
+        if (gameStatus != GS_OK) return CS_BAD_MOVE;
+        winPending = false;
+        rules.checkForWin(pileMap, state);
+        return CS_OK;
+    default:
+        break;
+    }
+
+    status = rules.validateCommand(pileMap, cdb);
+    if (status != CS_OK) return status;
+
+    // Command is valid; execute
+    switch (cdb.cmdId)
+    {
+    case _MOVE_CMD:
+    case _FORCE_CMD:
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        pDstPile = PILE(cdb.dst.pileType, cdb.dst.id);
+        beginStep();
+        // Cards entering or leaving the deck are turned over (draw, recycle)
+        if (cdb.src.pileType == DECK || cdb.dst.pileType == DECK) gameStatus = turnCards(pSrcPile, pDstPile, cdb.count);
+        else gameStatus = moveCards(pSrcPile, pDstPile, cdb.count);
+        endStep();
+        break;
+
+    case _FLIP_CMD:
+        beginStep();
+        gameStatus = flipTopCard(PILE(cdb.src.pileType, cdb.src.id));
+        endStep();
+        break;
+
+    case _DEAL_CMD:
+        // Rules lay out the deal; one cut short is taken back whole
+        beginStep();
+        gameStatus = rules.dealStock(*this);
+        if (gameStatus != GS_OK) cancelStep();
+        else endStep();
+        break;
+
+    default:
+        return CS_OK; // Nothing to execute on table
+    }
+    if (gameStatus != GS_OK) return CS_ERROR;
+
+    winPending = false;
+    rules.checkForWin(pileMap, state);
+
+    return CS_OK;
+}
+
+
+// Register the piles of a rules layout and make the opening deal
+template <class Rules>
+GameError_t SetUpTable(Game &game)
+{
+    GameError_t status;
+
+    for (const auto &layout : Rules::layout)
+    {
+        status = game.registerPile(layout.pileType, layout.count, layout.x, layout.y);
+        if (status != GS_OK) return status;
+    }
+
+    return game.deal(Rules::dealPileType, Rules::dealMethod, Rules::dealCount);
+}
+
+// Game with its rules fixed at compile time
+/* 'Rules' is a class of static members: 'checkForWin', 'validateCommand' and
+ * 'dealStock' with the 'RuleFuncs_t' signatures, 'deckType' and 'deckCount', a 'layout'
+ * table of piles to register, and 'dealPileType', 'dealMethod' and 'dealCount'
+ * ('0' for the whole deck) for the opening deal. Commands
+ * go straight to the rule functions, so they can be inlined into the engine;
+ * so does the win check made when the last card goes home. The base is built with the same functions as pointers, so code holding only
+ * a 'Game &' gets the same behaviour at run-time dispatch cost. */
+template <class Rules>
+class RulesGame : public Game
+{
+public:
+    RulesGame(uint gameSeed = INVALID_SEED, DealVersion_t gameDealVersion = DEAL_CURRENT)
+        : Game(Rules::deckType, Rules::checkForWin, Rules::validateCommand, gameSeed, gameDealVersion,
+               Rules::deckCount, Rules::dealStock) {}
+
+    inline GameError_t setUp()  { return SetUpTable<Rules>(*this); }
+    inline CmdError_t processCommand(Cdb_t &cdb)  { return dispatchCommand(cdb, Rules()); }
+
+    inline bool isGameFinished()  { settleWin(Rules()); return Game::isGameFinished(); }
+    inline bool isGameWon()       { settleWin(Rules()); return Game::isGameWon(); }
+    inline GameState_t getState()  { settleWin(Rules()); return Game::getState(); }
 };
 
 
 const QCommandLineOption & SetGameAppInfo(const QString &name, const QString &ver, const QString &description,
                     QCommandLineParser &parser);
+const QCommandLineOption & AddDealVersionOption(QCommandLineParser &parser);
+DealVersion_t GetDealVersion(const QCommandLineParser &parser, const QCommandLineOption &dealOpt);
+const QCommandLineOption & AddRenderModeOption(QCommandLineParser &parser);
+RenderMode_t GetRenderMode(const QCommandLineParser &parser, const QCommandLineOption &renderOpt);
 
 #endif // GAME_H
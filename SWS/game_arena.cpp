@@ -0,0 +1,74 @@
+#include <new>
+#include "game_arena.h"
+
+using namespace std;
+
+
+// Header size rounded up so block data keeps arena alignment
+#define BLOCK_HEADER_BYTES  ((sizeof(ArenaBlock_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+
+// New heap block of at least 'bytes' data bytes, linked in front of 'pNext'
+static ArenaBlock_t * newBlock(size_t bytes, ArenaBlock_t *pNext)
+{
+    size_t size = (bytes < ARENA_BLOCK_BYTES)? ARENA_BLOCK_BYTES : bytes;
+    char *pMem = static_cast<char *>(::operator new(BLOCK_HEADER_BYTES + size));
+    ArenaBlock_t *pNew = reinterpret_cast<ArenaBlock_t *>(pMem);
+
+    pNew->pNext = pNext;
+    pNew->size = size;
+    pNew->pData = pMem + BLOCK_HEADER_BYTES;
+
+    return pNew;
+}
+
+
+////////////////////////
+// GameArena class methods
+
+// Init GameArena object; only the inline block until more is needed
+GameArena::GameArena()
+{
+    head.pNext = nullptr;
+    head.size = ARENA_INLINE_BYTES;
+    head.pData = inlineData;
+    pBlock = &head;
+    used = 0;
+    reserved = ARENA_INLINE_BYTES;
+}
+
+// Free all heap blocks in one pass
+GameArena::~GameArena()
+{
+    ArenaBlock_t *pNext = head.pNext;
+
+    while (pNext != nullptr)
+    {
+        ArenaBlock_t *pFree = pNext;
+        pNext = pFree->pNext;
+        ::operator delete(pFree);
+    }
+}
+
+// Carve 'bytes' aligned to 'align' (a power of 2, at most 'ARENA_ALIGN'); moves
+//   on to the next kept block that fits, or links in a new one before it
+void * GameArena::alloc(size_t bytes, size_t align)
+{
+    for (;;)
+    {
+        size_t start = (used + align - 1) & ~(align - 1);
+
+        if (start + bytes <= pBlock->size)
+        {
+            used = start + bytes;
+            return pBlock->pData + start;
+        }
+        if (pBlock->pNext == nullptr || pBlock->pNext->size < bytes)
+        {
+            pBlock->pNext = newBlock(bytes, pBlock->pNext);
+            reserved += pBlock->pNext->size;
+        }
+        pBlock = pBlock->pNext;
+        used = 0;
+    }
+}
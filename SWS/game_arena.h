@@ -0,0 +1,51 @@
+#ifndef GAME_ARENA_H
+#define GAME_ARENA_H
+
+#include <cstddef>
+
+
+#define ARENA_INLINE_BYTES  (2 * 1024)   // Held in the arena object; a short game never touches the heap
+#define ARENA_BLOCK_BYTES   (16 * 1024)  // Smallest heap block
+#define ARENA_ALIGN         (alignof(std::max_align_t))
+
+
+// Arena block header; block data follows it
+typedef struct _ArenaBlock_t
+{
+    struct _ArenaBlock_t *pNext;  // Next block; kept when the arena is cleared
+    size_t size;                  // Data bytes
+    char *pData;
+} ArenaBlock_t;
+
+
+// Bump allocator owned by a game
+/* Allocations are carved from the inline block, then from heap blocks chained
+ * behind it, and are never freed one by one. 'clear' drops every allocation but
+ * keeps the blocks, so a game re-dealt in place asks for the same sizes and
+ * gets them from the blocks it already has; memory stays flat over any number
+ * of games. All heap blocks are freed together when the arena is destroyed. */
+class GameArena
+{
+public:
+    GameArena();
+    ~GameArena();
+
+    GameArena(const GameArena &) = delete;
+    GameArena & operator=(const GameArena &) = delete;
+
+    void * alloc(size_t bytes, size_t align = ARENA_ALIGN);
+    template <class T>
+    inline T * allocArray(int count)  { return static_cast<T *>(alloc(count * sizeof(T), alignof(T))); }
+    inline void clear()  { pBlock = &head; used = 0; }
+
+    inline size_t getReservedBytes() const  { return reserved; }  // Inline block included
+
+private:
+    ArenaBlock_t head;      // Inline block
+    ArenaBlock_t *pBlock;   // Block being carved
+    size_t used;            // Bytes carved from 'pBlock'
+    size_t reserved;
+    alignas(ARENA_ALIGN) char inlineData[ARENA_INLINE_BYTES];
+};
+
+#endif // GAME_ARENA_H
@@ -2,28 +2,34 @@
 #define GAME_COMMON_H
 
 #include "card.h"
+#include "card_stack.h"
 
 
 #define PILE_MAP          (pileMap)
 #define PILE_VECTOR(tid)  (pileMap[tid])
-#define PILE(tid, pid)    (pileMap[tid][pid])
-#define PILE_DECK         (pileMap[DECK][0])     // Assumes pile '0' as most
-#define PILE_DISCARD      (pileMap[DISCARD][0])  //   games only use a single
-#define PILE_WASTE        (pileMap[WASTE][0])    //   pile of this type
+#define PILE(tid, pid)    (pileMap.getPile(tid, pid))
+#define PILE_DECK         (pileMap.getPile(DECK, 0))     // Assumes pile '0' as most
+#define PILE_DISCARD      (pileMap.getPile(DISCARD, 0))  //   games only use a single
+#define PILE_WASTE        (pileMap.getPile(WASTE, 0))    //   pile of this type
 
 #define NEXT      (-1)  // Offset for next card
 #define PREVIOUS  (1)   // Offset for previous card
 
 #define INVALID_PILE_ID  (-1)
 
+#define MAX_PILES_PER_TABLE  (32)
+#define PILE_BIT(idx)        (1u << (idx))  // Pile table index bit in a pile mask
+#define PILE_MASK_ALL        (0xffffffffu)
+
 
 // Deck deal methods
 typedef enum
 {
-    SINGLE,
-    INCREMENTING,
-    DECREMENTING,
-    ALL
+    SINGLE,        // One card face up to each pile
+    INCREMENTING,  // Pile 'n' gets 'n + 1' cards, top face up (Klondike)
+    DECREMENTING,  // Pile 'n' gets 'count - n' cards, top face up
+    ALL,           // Round robin until the deck (or deal count) runs out, tops face up (Spider)
+    ALL_FACE_UP    // As 'ALL', every card face up (FreeCell)
 } DealMethod_t;
 
 // Print styles (and standard uses)
@@ -48,6 +54,8 @@ typedef enum
     GS_OK                 = 0x00,  // OK
     GS_INS_PILE_SIZE      = 0x01,  // Insufficient pile size
     GS_EMPTY_PILE         = 0x02,  // Empty pile
+    GS_PILE_FULL          = 0x03,  // Destination pile at capacity
+    GS_NO_HISTORY         = 0x04,  // Nothing to undo/redo
     GS_ERROR              = 0x0f   // Misc error
 } GameError_t;
 
@@ -60,6 +68,25 @@ typedef enum
     GAME_OVER          // Game has become unwinnable
 } GameState_t;
 
+// Solver results
+typedef enum
+{
+    SS_SOLVED,        // Winning move sequence found
+    SS_UNSOLVABLE,    // Proven that no win exists
+    SS_NO_WIN_FOUND,  // Search ended without a win; not a proof, as moves are pruned
+    SS_NODE_LIMIT,    // Node limit reached before a result
+    SS_MEMORY_LIMIT,  // Memory cap reached before a result
+    SS_ERROR          // Position could not be captured
+} SolveStatus_t;
+
+// Card location on table
+typedef struct _CardLoc_t
+{
+    quint8 pile;   // Pile table index; 'CARD_LOC_NONE' if not on table
+    quint8 depth;  // Position in pile from bottom card
+} CardLoc_t;
+#define CARD_LOC_NONE  (0xff)
+
 // 2D coordinate container
 typedef struct _Coord_t
 {
@@ -81,9 +108,29 @@ typedef enum
 } PileType_t;
 #define IS_VALID_PILE_TYPE(p)  ((p) != INVALID_PILE_TYPE)
 
-typedef QVector<Card *> Pile_t;                    // A vector of [pointers to] cards that form a pile
-typedef QVector<class Pile *> PileVector_t;        // Vector of [pointers to] pile objects of a particular type
-typedef QMap<PileType_t, PileVector_t> PileMap_t;  // Mapping of all piles/types on table
+// Piles of one type to register, as a rules layout table entry
+typedef struct _PileLayout_t
+{
+    PileType_t pileType;
+    int count;
+    int x;  // Location of first pile; the rest follow on the same row
+    int y;
+} PileLayout_t;
+
+// Move between piles, as produced by a rules move generator
+typedef struct _GameMove_t
+{
+    quint8 srcType;  // PileType_t
+    quint8 srcId;
+    quint8 dstType;  // PileType_t
+    quint8 dstId;
+    quint8 count;
+} GameMove_t;
+
+
+typedef CardStack<PILE_CAPACITY> Pile_t;           // Inline stack of cards that form a pile
+typedef class PileVector PileVector_t;             // Contiguous view of the pile objects of a particular type
+typedef class PileTable PileMap_t;                 // Flat table of all piles/types on table
 
 
 class Pile;
@@ -1,82 +1,24 @@
-#include <QCoreApplication>
-#include <QCommandLineParser>
-#include <QDebug>
-#include "game.h"
+#include "klondike.h"
+#include "klondike_rules.h"
 
-using namespace std;
 
+constexpr PileLayout_t KlondikeRules::layout[];
 
-#define KLONDIKE_TABLEAU_COUNT     (7)
-#define KLONDIKE_FOUNDATION_COUNT  (4)
 
-
-// Check for winning condition
+// Check for winning condition; run-time pointer adapter for 'KlondikeRules'
 void klondikeCheckForWin(PileMap_t &pileMap, GameState_t &state)
 {
-    // Cycle foundations
-    for (auto pPile : PILE_VECTOR(FOUNDATION))
-    {
-        if (pPile->topCard()->getValue() != KING)
-        {
-            return;
-        }
-    }
-    state = GAME_WON;
+    KlondikeRules::checkForWin(pileMap, state);
 }
 
-// Validate command
-CmdError_t klondikeValidateCmd(Cdb_t &cdb)
+// Validate command against table; run-time pointer adapter for 'KlondikeRules'
+CmdError_t klondikeValidateCmd(PileMap_t &pileMap, Cdb_t &cdb)
 {
-    return CS_ERROR;
+    return KlondikeRules::validateCommand(pileMap, cdb);
 }
 
-// Klondike game loop
-int Klondike(int argc, char *argv[])
+// Register Klondike piles and deal opening tableau
+GameError_t KlondikeSetUp(Game &klondike)
 {
-    QCoreApplication app(argc, argv);
-    QCommandLineParser parser;
-    bool gameSeedOk;
-    uint gameSeed = 0;
-    Cdb_t cdb;
-    CmdError_t cmdStatus;
-
-    // Set up game app
-    const QCommandLineOption seedOpt = SetGameAppInfo("Klondike", "2.0", "SWS Klondike console game", parser);
-
-    // Parse and handle
-    parser.process(app);
-    if (parser.isSet(seedOpt))
-    {
-        gameSeed = parser.value(seedOpt).toUInt(&gameSeedOk);
-        if (!gameSeedOk) gameSeed = 0; // Reset if failed
-    }
-
-    // Create game control object
-    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, gameSeed);
-    GameConsole console;
-    qDebug() << "... Game object instantiated";
-    qDebug() << "... Game seed:" << klondike.getDeckSeed();
-
-    // Init game piles
-    klondike.registerPile(DECK, 1, 0, 0);
-    klondike.registerPile(DISCARD, 1, 1, 0);
-    klondike.registerPile(FOUNDATION, KLONDIKE_FOUNDATION_COUNT, 3, 0);
-    klondike.registerPile(TABLEAU, KLONDIKE_TABLEAU_COUNT, 0, 1);
-    qDebug() << "... Piles registered";
-
-    // Deal cards to piles
-    klondike.deal(TABLEAU, INCREMENTING);
-    qDebug() << "... Cards dealt";
-
-    // Game loop
-    do
-    {
-        klondike.print(console); // Print table
-        cmdStatus = console.collectInput(cdb); // Collect input
-        // Handle command
-        break;
-    } while(!klondike.isGameFinished());
-    qDebug() << "... Game loop exited";
-
-    return 0;
+    return SetUpTable<KlondikeRules>(klondike);
 }
@@ -1,7 +1,16 @@
 #ifndef KLONDIKE_H
 #define KLONDIKE_H
 
+#include "game.h"
 
-int Klondike(int argc, char *argv[]);
+
+#define KLONDIKE_TABLEAU_COUNT     (7)
+#define KLONDIKE_FOUNDATION_COUNT  (4)
+
+
+void klondikeCheckForWin(PileMap_t &pileMap, GameState_t &state);
+CmdError_t klondikeValidateCmd(PileMap_t &pileMap, Cdb_t &cdb);
+
+GameError_t KlondikeSetUp(Game &klondike);
 
 #endif // KLONDIKE_H
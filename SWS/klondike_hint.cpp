@@ -0,0 +1,178 @@
+#include "klondike_hint.h"
+
+using namespace std;
+
+
+// Moves are the same
+static inline bool sameMove(const KlondikeMove_t &a, const KlondikeMove_t &b)
+{
+    return a.srcType == b.srcType && a.srcId == b.srcId && a.dstType == b.dstType && a.dstId == b.dstId &&
+           a.count == b.count;
+}
+
+
+////////////////////////////////
+// KlondikeHintEngine class methods
+
+KlondikeHintEngine::KlondikeHintEngine(int threadCount)
+{
+    if (threadCount < 1) threadCount = thread::hardware_concurrency();
+    if (threadCount < 1) threadCount = 1;
+
+    this->threadCount = threadCount;
+    sampleCount = HINT_DEFAULT_SAMPLES;
+    nodeLimit = HINT_DEFAULT_NODE_LIMIT;
+    timeBudget = HINT_DEFAULT_TIME_MS;
+    jobId = 0;
+    busy = 0;
+    quit = false;
+    jobSeed = 0;
+    unseenCount = 0;
+    nextSample = 0;
+    voteMoves = 0;
+    samplesDone = 0;
+    winsDone = 0;
+}
+
+KlondikeHintEngine::~KlondikeHintEngine()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) worker.join();
+}
+
+// Hint for a live game
+bool KlondikeHintEngine::hint(Game &game, KlondikeHint_t &result)
+{
+    KlondikeState_t st;
+
+    if (!KlondikeStateFromGame(st, game)) return false;
+
+    return hint(st, result, game.getHash());
+}
+
+// Sample, solve and vote from position 'st'; returns 'false' if the position
+//   is already won or no sample could be run
+bool KlondikeHintEngine::hint(const KlondikeState_t &st, KlondikeHint_t &result, quint64 seed)
+{
+    int idx = st.stockCount + st.wasteCount;
+    int best = -1;
+
+    memset(&result, 0, sizeof(result));
+    if (KlondikeStateIsWon(st)) return false;
+
+    // Set up job: stock and face-down tableau cards are unseen
+    root = st;
+    jobSeed = seed;
+    unseenCount = 0;
+    for (auto i = 0; i < st.stockCount; i++) unseenSlot[unseenCount++] = i;
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        for (auto i = 0; i < st.faceDownCount[t]; i++) unseenSlot[unseenCount++] = idx + i;
+        idx += st.tableauCount[t];
+    }
+    nextSample = 0;
+    voteMoves = 0;
+    samplesDone = 0;
+    winsDone = 0;
+    deadline = chrono::steady_clock::now() + chrono::milliseconds(timeBudget);
+
+    // Start pool on first use, then run job to completion
+    if (workers.empty())
+    {
+        for (auto t = 0; t < threadCount; t++) workers.push_back(thread(&KlondikeHintEngine::workerLoop, this));
+    }
+    {
+        unique_lock<mutex> guard(lock);
+        jobId++;
+        busy = threadCount;
+        wake.notify_all();
+        jobDone.wait(guard, [this] { return busy == 0; });
+    }
+
+    if (samplesDone == 0) return false;
+
+    // Most voted first move; votes arrive in scheduling order, so ties go by sample
+    for (auto v = 0; v < voteMoves; v++)
+    {
+        if (best < 0 || voteCount[v] > voteCount[best] ||
+            (voteCount[v] == voteCount[best] && voteFirst[v] < voteFirst[best])) best = v;
+    }
+    result.samples = samplesDone;
+    result.wins = winsDone;
+    result.winChance = (double)winsDone / samplesDone;
+    if (best >= 0)
+    {
+        result.move = voteMove[best];
+        result.moveWins = voteCount[best];
+    }
+
+    return true;
+}
+
+// Pool worker; sleeps between jobs and keeps its solver's tables across them
+void KlondikeHintEngine::workerLoop()
+{
+    KlondikeSolver solver(HINT_MEMORY_CAP);
+    quint32 seenJob = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [this, seenJob] { return quit || jobId != seenJob; });
+            if (quit) return;
+            seenJob = jobId;
+        }
+
+        solver.setNodeLimit(nodeLimit);
+        for (int sample = nextSample++; sample < sampleCount; sample = nextSample++)
+        {
+            if (chrono::steady_clock::now() >= deadline) break;
+            runSample(solver, sample);
+        }
+
+        lock_guard<mutex> guard(lock);
+        if (--busy == 0) jobDone.notify_one();
+    }
+}
+
+// Deal unseen cards for one sample, solve and record the vote
+void KlondikeHintEngine::runSample(KlondikeSolver &solver, int sample)
+{
+    KlondikeState_t st = root;
+    KlondikeMoveList_t solution;
+    quint64 rng = jobSeed ^ ((quint64)sample * 0xd1b54a32d192ed03ULL);
+
+    // Shuffle unseen cards among their own slots
+    for (auto i = unseenCount - 1; i > 0; i--)
+    {
+        swap(st.cards[unseenSlot[i]], st.cards[unseenSlot[BoundedDraw(rng, i + 1)]]);
+    }
+
+    SolveStatus_t status = solver.solve(st, solution);
+
+    lock_guard<mutex> guard(lock);
+    samplesDone++;
+    if (status != SS_SOLVED || solution.isEmpty()) return;
+
+    winsDone++;
+    for (auto v = 0; v < voteMoves; v++)
+    {
+        if (sameMove(voteMove[v], solution.first()))
+        {
+            voteCount[v]++;
+            if (sample < voteFirst[v]) voteFirst[v] = sample;
+            return;
+        }
+    }
+    if (voteMoves < KLONDIKE_MAX_MOVES)
+    {
+        voteMove[voteMoves] = solution.first();
+        voteCount[voteMoves] = 1;
+        voteFirst[voteMoves++] = sample;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef KLONDIKE_HINT_H
+#define KLONDIKE_HINT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "klondike_solver.h"
+
+
+#define HINT_DEFAULT_SAMPLES     (256)
+#define HINT_DEFAULT_NODE_LIMIT  (20000)      // Per sample
+#define HINT_DEFAULT_TIME_MS     (150)        // No new samples are started past this
+#define HINT_MEMORY_CAP          (4u << 20)   // Solver memory per worker (bytes)
+
+
+// Hint result
+typedef struct _KlondikeHint_t
+{
+    KlondikeMove_t move;  // Suggested move, possibly a flip; valid only if 'moveWins' is non-zero
+    int samples;          // Deals sampled
+    int wins;             // Samples solved
+    int moveWins;         // Samples solved starting with 'move'
+    double winChance;     // 'wins' / 'samples'; unresolved samples count as losses
+} KlondikeHint_t;
+
+
+// Determinized Monte Carlo hint engine
+/* The player cannot see the stock or the face-down tableau cards, so solving
+ * the true deal would leak them. Instead each sample deals the unseen cards
+ * into their slots at random, keeping everything visible, and runs a bounded
+ * solve. The first move of each solution found gets a vote; the most voted
+ * move is the hint, ties going to the move voted for by the lowest-numbered
+ * sample, and the share of solved samples estimates the chance of
+ * winning. Samples are spread over a pool of worker threads that is started
+ * on first use and kept for later hints; each sample's deal depends only on
+ * the hint seed and sample number, so results do not depend on scheduling
+ * unless the time budget cuts sampling short. */
+class KlondikeHintEngine
+{
+public:
+    KlondikeHintEngine(int threadCount = 0);  // '0' for one per hardware thread
+    ~KlondikeHintEngine();
+
+    bool hint(const KlondikeState_t &st, KlondikeHint_t &result, quint64 seed = 1);
+    bool hint(Game &game, KlondikeHint_t &result);
+
+    inline void setSampleCount(int count)    { sampleCount = count; }
+    inline void setNodeLimit(quint64 limit)  { nodeLimit = limit; }
+    inline void setTimeBudget(int msec)      { timeBudget = msec; }
+    inline int getThreadCount() const        { return threadCount; }
+
+private:
+    void workerLoop();
+    void runSample(KlondikeSolver &solver, int sample);
+
+    // Settings
+    int threadCount;
+    int sampleCount;
+    quint64 nodeLimit;
+    int timeBudget;
+
+    // Pool
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;     // Workers wait here for a job
+    std::condition_variable jobDone;  // Caller waits here for the workers
+    quint32 jobId;
+    int busy;
+    bool quit;
+
+    // Current job; fixed while workers run
+    KlondikeState_t root;
+    quint64 jobSeed;
+    int unseenSlot[CARDS_PER_STD_DECK];  // 'cards' indices holding unseen cards
+    int unseenCount;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<int> nextSample;
+
+    // Job results; guarded by 'lock'
+    KlondikeMove_t voteMove[KLONDIKE_MAX_MOVES];
+    int voteCount[KLONDIKE_MAX_MOVES];
+    int voteFirst[KLONDIKE_MAX_MOVES];  // Lowest sample voting for the move
+    int voteMoves;
+    int samplesDone;
+    int winsDone;
+};
+
+#endif // KLONDIKE_HINT_H
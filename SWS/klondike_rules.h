@@ -0,0 +1,199 @@
+#ifndef KLONDIKE_RULES_H
+#define KLONDIKE_RULES_H
+
+#include "klondike_state.h"
+
+
+// Klondike rules for 'RulesGame'; also behind the 'klondikeCheckForWin' and
+//   'klondikeValidateCmd' pointers
+class KlondikeRules
+{
+public:
+    static const DeckType_t deckType = STD_DECK;
+    static const int deckCount = 1;
+    static constexpr PileLayout_t layout[] = {
+        {DECK,       1,                         0, 0},
+        {DISCARD,    1,                         1, 0},
+        {FOUNDATION, KLONDIKE_FOUNDATION_COUNT, 3, 0},
+        {TABLEAU,    KLONDIKE_TABLEAU_COUNT,    0, 1}
+    };
+    static const PileType_t dealPileType = TABLEAU;
+    static const DealMethod_t dealMethod = INCREMENTING;
+    static const int dealCount = 0;
+
+    static inline void checkForWin(PileMap_t &pileMap, GameState_t &state);
+    static inline CmdError_t validateCommand(PileMap_t &pileMap, Cdb_t &cdb);
+    static inline GameError_t dealStock(Game &)  { return GS_ERROR; }  // No stock deal
+
+private:
+    static inline bool isOnTable(PileMap_t &pileMap, const CdbPileItem_t &item);
+    static inline bool fitsFoundation(Card card, Pile *pPile);
+    static inline bool fitsTableau(Card card, Pile *pPile);
+    static inline CmdError_t validateMove(PileMap_t &pileMap, Cdb_t &cdb, Pile *pSrcPile, Pile *pDstPile);
+};
+
+
+// Pile item names an existing pile of the table
+inline bool KlondikeRules::isOnTable(PileMap_t &pileMap, const CdbPileItem_t &item)
+{
+    return PILE_MAP.contains(item.pileType) && item.id >= 0 && item.id < PILE_VECTOR(item.pileType).size();
+}
+
+// Card may be placed on foundation pile
+inline bool KlondikeRules::fitsFoundation(Card card, Pile *pPile)
+{
+    Card top = pPile->topCard();
+
+    if (top.isNull()) return card.getValue() == ACE;
+
+    return card.getSuit() == top.getSuit() && card.getValue() == top.getValue() + 1;
+}
+
+// Card may be placed on tableau pile
+inline bool KlondikeRules::fitsTableau(Card card, Pile *pPile)
+{
+    Card top = pPile->topCard();
+
+    if (top.isNull()) return card.getValue() == KING;
+
+    return top.isFaceUp() && top.isRed() != card.isRed() && top.getValue() == card.getValue() + 1;
+}
+
+// Validate Klondike move and set card count
+inline CmdError_t KlondikeRules::validateMove(PileMap_t &pileMap, Cdb_t &cdb, Pile *pSrcPile, Pile *pDstPile)
+{
+    int cnt = pSrcPile->getCardCount();
+
+    // Stock draw and waste recycle
+    if (cdb.src.pileType == DECK)
+    {
+        if (cdb.dst.pileType != DISCARD) return CS_BAD_MOVE;
+        cdb.count = 1;
+        return CS_OK;
+    }
+    if (cdb.dst.pileType == DECK)
+    {
+        if (cdb.src.pileType != DISCARD || PILE_DECK->getCardCount() != 0) return CS_BAD_MOVE;
+        cdb.count = cnt;
+        return CS_OK;
+    }
+
+    Card card = pSrcPile->topCard();
+    if (!card.isFaceUp()) return CS_BAD_MOVE;
+
+    switch (cdb.dst.pileType)
+    {
+    case FOUNDATION:
+        if (cdb.src.pileType == FOUNDATION || !fitsFoundation(card, pDstPile)) return CS_BAD_MOVE;
+        cdb.count = 1;
+        return CS_OK;
+
+    case TABLEAU:
+        if (cdb.src.pileType != TABLEAU)
+        {
+            if (!fitsTableau(card, pDstPile)) return CS_BAD_MOVE;
+            cdb.count = 1;
+            return CS_OK;
+        }
+
+        // Find card of the face-up run that fits; the run moves from there up
+        for (auto i = cnt - 1; i >= 0; i--)
+        {
+            Card runCard = pSrcPile->getCardAt(i);
+            if (!runCard.isFaceUp()) break;
+            if (i < cnt - 1 && !(card.isRed() != runCard.isRed() && runCard.getValue() == card.getValue() + 1)) break;
+            if (fitsTableau(runCard, pDstPile))
+            {
+                cdb.count = cnt - i;
+                return CS_OK;
+            }
+            card = runCard;
+        }
+        return CS_BAD_MOVE;
+
+    default:
+        return CS_BAD_MOVE;
+    }
+}
+
+// Check for winning condition, or a full deck that can no longer be won
+inline void KlondikeRules::checkForWin(PileMap_t &pileMap, GameState_t &state)
+{
+    KlondikeState_t st;
+
+    if (PILE_MAP.isIndexed())
+    {
+        if (PILE_MAP.getCardMask(FOUNDATION) == PILE_MAP.getTableMask()) state = GAME_WON;
+        else if (PILE_MAP.getTableMask() == CARD_MASK_ALL && KlondikeStateFromPileMap(st, pileMap) &&
+                 KlondikeStateIsDeadEnd(st)) state = GAME_OVER;
+        return;
+    }
+
+    // Won when nothing is left off the foundations
+    for (auto pPile : PILE_MAP)
+    {
+        if (pPile->getType() != FOUNDATION && pPile->getCardCount() != 0)
+        {
+            return;
+        }
+    }
+    state = GAME_WON;
+}
+
+// Validate command against table; sets card count of a move, which must match
+//   any count given in the command
+inline CmdError_t KlondikeRules::validateCommand(PileMap_t &pileMap, Cdb_t &cdb)
+{
+    Pile *pSrcPile;
+    Pile *pDstPile;
+    int given = cdb.count;
+    CmdError_t status;
+
+    cdb.count = 0;
+    switch (cdb.cmdId)
+    {
+    case _CLEAR_CMD:
+    case _KEY_CMD:
+    case _QUIT_CMD:
+    case _UNDO_CMD:
+    case _REDO_CMD:
+    case _HINT_CMD:
+        return CS_OK;
+
+    case _FLIP_CMD:
+        // Only a face-down tableau top may be turned up
+        if (!IS_VALID_PILE_TYPE(cdb.src.pileType)) return CS_MISSING_ARGS;
+        if (!isOnTable(pileMap, cdb.src)) return CS_BAD_ARG_1;
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        if (cdb.src.pileType != TABLEAU || pSrcPile->getCardCount() == 0 || pSrcPile->topCard().isFaceUp())
+        {
+            return CS_BAD_MOVE;
+        }
+        cdb.count = 1;
+        return CS_OK;
+
+    case _MOVE_CMD:
+    case _FORCE_CMD:
+        if (!IS_VALID_PILE_TYPE(cdb.src.pileType) || !IS_VALID_PILE_TYPE(cdb.dst.pileType)) return CS_MISSING_ARGS;
+        if (!isOnTable(pileMap, cdb.src)) return CS_BAD_ARG_1;
+        if (!isOnTable(pileMap, cdb.dst)) return CS_BAD_ARG_2;
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        pDstPile = PILE(cdb.dst.pileType, cdb.dst.id);
+        if (pSrcPile == pDstPile || pSrcPile->getCardCount() == 0) return CS_BAD_MOVE;
+
+        // Forced move skips the rules; top card only
+        if (cdb.cmdId == _FORCE_CMD)
+        {
+            cdb.count = 1;
+            return (given <= 1)? CS_OK : CS_BAD_MOVE;
+        }
+        status = validateMove(pileMap, cdb, pSrcPile, pDstPile);
+        if (status == CS_OK && given != 0 && given != cdb.count) status = CS_BAD_MOVE;
+        return status;
+
+    default:
+        return CS_BAD_CMD;
+    }
+}
+
+#endif // KLONDIKE_RULES_H
@@ -0,0 +1,306 @@
+#include "klondike_rules.h"
+#include "klondike_solver.h"
+
+using namespace std;
+
+
+#define SOLVER_INITIAL_DEPTH  (256)
+
+#define ADD_MOVE(st, si, dt, di, n)  \
+    do { KlondikeMove_t &m = pMoves[moveCnt++]; m.srcType = (st); m.srcId = (si); m.dstType = (dt); m.dstId = (di); m.count = (n); } while (0)
+
+
+// Foundation summary gathered once per position
+typedef struct _Home_t
+{
+    int rank[SUITS_PER_STD_DECK];        // Top rank home per suit; '0' if none
+    int foundation[SUITS_PER_STD_DECK];  // Foundation holding suit; -1 if none
+    int firstEmpty;                      // First empty foundation; -1 if none
+} Home_t;
+
+static inline void gatherHome(const KlondikeState_t &st, Home_t &home)
+{
+    for (auto s = 0; s < SUITS_PER_STD_DECK; s++)
+    {
+        home.rank[s] = 0;
+        home.foundation[s] = -1;
+    }
+    home.firstEmpty = -1;
+
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++)
+    {
+        quint8 code = st.foundation[f];
+        if (code == KLONDIKE_EMPTY_FOUNDATION)
+        {
+            if (home.firstEmpty < 0) home.firstEmpty = f;
+            continue;
+        }
+        int suit = (code & CARD_SUIT_MASK) >> CARD_SUIT_SHIFT;
+        home.rank[suit] = KCODE_VALUE(code);
+        home.foundation[suit] = f;
+    }
+}
+
+// Foundation accepting card code, or -1; aces go to the first empty foundation
+static inline int foundationFor(const Home_t &home, quint8 code)
+{
+    int suit = (code & CARD_SUIT_MASK) >> CARD_SUIT_SHIFT;
+
+    if (KCODE_VALUE(code) == ACE) return home.firstEmpty;
+    if (home.rank[suit] != KCODE_VALUE(code) - 1) return -1;
+
+    return home.foundation[suit];
+}
+
+// Card code may be placed on tableau top code ('0' for empty pile)
+static inline bool fitsOn(quint8 code, quint8 topCode)
+{
+    if (topCode == 0) return KCODE_VALUE(code) == KING;
+
+    return (KCODE_VALUE(topCode) == KCODE_VALUE(code) + 1) && (KCODE_IS_RED(topCode) != KCODE_IS_RED(code));
+}
+
+// Card can go home without ever being needed in the tableau again: both
+//   opposite-colour cards one rank lower are already home
+static inline bool isSafeHome(const Home_t &home, quint8 code)
+{
+    int rank = KCODE_VALUE(code);
+
+    if (rank <= TWO) return true;
+    if (KCODE_IS_RED(code)) return (home.rank[CLUBS] >= rank - 1) && (home.rank[SPADES] >= rank - 1);
+
+    return (home.rank[HEARTS] >= rank - 1) && (home.rank[DIAMONDS] >= rank - 1);
+}
+
+// Generate candidate moves in search order; turning up a face-down top, or
+//   else a safe move home, if any, is returned alone
+static int genMoves(const KlondikeState_t &st, KlondikeMove_t *pMoves)
+{
+    int moveCnt = 0;
+    int off[KLONDIKE_TABLEAU_COUNT];
+    quint8 top[KLONDIKE_TABLEAU_COUNT];
+    Home_t home;
+    quint8 wasteTop = (st.wasteCount != 0)? st.cards[st.stockCount] : 0;
+    int firstEmpty = -1;
+    int f;
+
+    // Gather pile tops; a face-down one is turned up first, as it can only help
+    off[0] = st.stockCount + st.wasteCount;
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        if (st.tableauCount[t] != 0 && st.faceDownCount[t] == st.tableauCount[t])
+        {
+            moveCnt = 0;
+            ADD_MOVE(TABLEAU, t, TABLEAU, t, 1);
+            return moveCnt;
+        }
+        if (t > 0) off[t] = off[t - 1] + st.tableauCount[t - 1];
+        top[t] = (st.tableauCount[t] != 0)? st.cards[off[t] + st.tableauCount[t] - 1] : 0;
+        if (top[t] == 0 && firstEmpty < 0) firstEmpty = t;
+    }
+    gatherHome(st, home);
+
+    // Moves home; a safe one is played on its own
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        if (top[t] == 0 || (f = foundationFor(home, top[t])) < 0) continue;
+        if (isSafeHome(home, top[t]))
+        {
+            moveCnt = 0;
+            ADD_MOVE(TABLEAU, t, FOUNDATION, f, 1);
+            return moveCnt;
+        }
+        ADD_MOVE(TABLEAU, t, FOUNDATION, f, 1);
+    }
+    if (wasteTop != 0 && (f = foundationFor(home, wasteTop)) >= 0)
+    {
+        if (isSafeHome(home, wasteTop))
+        {
+            moveCnt = 0;
+            ADD_MOVE(DISCARD, 0, FOUNDATION, f, 1);
+            return moveCnt;
+        }
+        ADD_MOVE(DISCARD, 0, FOUNDATION, f, 1);
+    }
+
+    // Tableau runs; whole face-up runs that turn a card first, then the rest
+    for (auto pass = 0; pass < 2; pass++)
+    {
+        for (auto s = 0; s < KLONDIKE_TABLEAU_COUNT; s++)
+        {
+            int fd = st.faceDownCount[s];
+            int cnt = st.tableauCount[s];
+            if (cnt == fd) continue;
+
+            quint8 base = st.cards[off[s] + fd];
+            for (auto d = 0; d < KLONDIKE_TABLEAU_COUNT; d++)
+            {
+                int i;
+
+                if (d == s) continue;
+                if (top[d] == 0)
+                {
+                    // King run to the first empty pile; pointless from a pile bottom
+                    if (d != firstEmpty || KCODE_VALUE(base) != KING || fd == 0) continue;
+                    i = fd;
+                }
+                else
+                {
+                    i = fd + KCODE_VALUE(base) - (KCODE_VALUE(top[d]) - 1);
+                    if (i < fd || i >= cnt || !fitsOn(st.cards[off[s] + i], top[d])) continue;
+                }
+
+                if (pass == 0)
+                {
+                    if (i == fd && fd > 0) ADD_MOVE(TABLEAU, s, TABLEAU, d, cnt - i);
+                }
+                else if (i == fd)
+                {
+                    if (fd == 0) ADD_MOVE(TABLEAU, s, TABLEAU, d, cnt - i);
+                }
+                else if (foundationFor(home, st.cards[off[s] + i - 1]) >= 0)
+                {
+                    // Split run only to free the card beneath for its foundation
+                    ADD_MOVE(TABLEAU, s, TABLEAU, d, cnt - i);
+                }
+            }
+        }
+
+        // Waste to tableau between the two run passes
+        if (pass == 0 && wasteTop != 0)
+        {
+            for (auto d = 0; d < KLONDIKE_TABLEAU_COUNT; d++)
+            {
+                if (top[d] == 0 && d != firstEmpty) continue;
+                if (fitsOn(wasteTop, top[d])) ADD_MOVE(DISCARD, 0, TABLEAU, d, 1);
+            }
+        }
+    }
+
+    // Draw or recycle
+    if (st.stockCount != 0) ADD_MOVE(DECK, 0, DISCARD, 0, 1);
+    else if (st.wasteCount != 0) ADD_MOVE(DISCARD, 0, DECK, 0, st.wasteCount);
+
+    // Foundation back to tableau; never for a card that is safe at home
+    for (f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++)
+    {
+        quint8 code = st.foundation[f];
+        if (code == KLONDIKE_EMPTY_FOUNDATION || isSafeHome(home, code)) continue;
+        for (auto d = 0; d < KLONDIKE_TABLEAU_COUNT; d++)
+        {
+            if (top[d] == 0 && d != firstEmpty) continue;
+            if (fitsOn(code, top[d])) ADD_MOVE(FOUNDATION, f, TABLEAU, d, 1);
+        }
+    }
+
+    return moveCnt;
+}
+
+
+////////////////////////////////
+// KlondikeSolver class methods
+
+KlondikeSolver::KlondikeSolver(size_t memoryCap) : tt(memoryCap)
+{
+    nodeLimit = 0;
+    nodeCount = 0;
+    bestHome = 0;
+    this->memoryCap = memoryCap;
+    stack.reserve(SOLVER_INITIAL_DEPTH);
+}
+
+// Search for a winning move sequence from 'root'
+SolveStatus_t KlondikeSolver::solve(const KlondikeState_t &root, KlondikeMoveList_t &solution)
+{
+    int depth = 0;
+
+    solution.clear();
+    tt.clear();
+    nodeCount = 0;
+    bestHome = CARDS_PER_STD_DECK - KlondikeCardsLeft(root);
+
+    if (KlondikeStateIsWon(root)) return SS_SOLVED;
+    if (KlondikeStateIsDeadEnd(root)) return SS_UNSOLVABLE; // Hopeless; skip search
+
+    // Seed stack with root position
+    if (stack.size() < SOLVER_INITIAL_DEPTH) stack.resize(SOLVER_INITIAL_DEPTH);
+    stack[0].st = root;
+    stack[0].moveCnt = genMoves(root, stack[0].moves);
+    stack[0].next = 0;
+    tt.insert(KlondikeStateHash(root));
+
+    while (depth >= 0)
+    {
+        Frame_t *pFrame = &stack[depth];
+
+        if (pFrame->next == pFrame->moveCnt)
+        {
+            depth--; // Exhausted; backtrack
+            continue;
+        }
+        pFrame->next++;
+
+        // Grow stack within memory cap
+        if (depth + 1 == stack.size())
+        {
+            size_t stackBytes = (size_t)stack.size() * 2 * sizeof(Frame_t);
+            if (stackBytes + tt.getMemoryUsage() > memoryCap) return SS_MEMORY_LIMIT;
+            stack.resize(stack.size() * 2);
+            pFrame = &stack[depth];
+        }
+
+        // Play move into child frame
+        Frame_t *pChild = &stack[depth + 1];
+        pChild->st = pFrame->st;
+        KlondikeStateApply(pChild->st, pFrame->moves[pFrame->next - 1]);
+
+        int home = CARDS_PER_STD_DECK - KlondikeCardsLeft(pChild->st);
+        if (home > bestHome) bestHome = home;
+        if (home == CARDS_PER_STD_DECK)
+        {
+            for (auto d = 0; d <= depth; d++) solution.append(stack[d].moves[stack[d].next - 1]);
+            return SS_SOLVED;
+        }
+
+        switch (tt.insert(KlondikeStateHash(pChild->st)))
+        {
+        case TT_PRESENT:
+            continue;
+        case TT_FULL:
+            return SS_MEMORY_LIMIT;
+        default:
+            break;
+        }
+
+        if (nodeLimit != 0 && nodeCount >= nodeLimit) return SS_NODE_LIMIT;
+        nodeCount++;
+
+        pChild->moveCnt = genMoves(pChild->st, pChild->moves);
+        pChild->next = 0;
+        depth++;
+    }
+
+    return SS_NO_WIN_FOUND; // Pruned moves and hash-only matches make this no proof
+}
+
+// Search from live game position
+SolveStatus_t KlondikeSolver::solve(Game &game, KlondikeMoveList_t &solution)
+{
+    KlondikeState_t st;
+
+    solution.clear();
+    if (!KlondikeStateFromGame(st, game)) return SS_ERROR;
+
+    return solve(st, solution);
+}
+
+// Search from the opening deal for a deck seed
+SolveStatus_t KlondikeSolver::solveSeed(uint seed, KlondikeMoveList_t &solution, DealVersion_t dealVersion)
+{
+    RulesGame<KlondikeRules> klondike(seed, dealVersion);
+
+    solution.clear();
+    if (klondike.setUp() != GS_OK) return SS_ERROR;
+
+    return solve(klondike, solution);
+}
@@ -0,0 +1,50 @@
+#ifndef KLONDIKE_SOLVER_H
+#define KLONDIKE_SOLVER_H
+
+#include <QVector>
+#include "klondike_state.h"
+#include "transposition_table.h"
+
+
+typedef QVector<KlondikeMove_t> KlondikeMoveList_t;
+
+
+// Depth-first Klondike solver (draw one, unlimited redeals) over compact
+//   states, with a transposition table of visited position hashes. Moves are
+//   pruned and positions matched by hash, so an exhausted search only reports
+//   'SS_NO_WIN_FOUND'; 'SS_UNSOLVABLE' is kept for proven dead ends. A
+//   solution holds the flip moves the engine needs, so it replays on a 'Game'
+//   command by command.
+class KlondikeSolver
+{
+public:
+    KlondikeSolver(size_t memoryCap = TT_DEFAULT_MEMORY_CAP);
+
+    SolveStatus_t solve(const KlondikeState_t &root, KlondikeMoveList_t &solution);
+    SolveStatus_t solve(Game &game, KlondikeMoveList_t &solution);
+    SolveStatus_t solveSeed(uint seed, KlondikeMoveList_t &solution, DealVersion_t dealVersion = DEAL_CURRENT);
+
+    inline void setNodeLimit(quint64 limit)  { nodeLimit = limit; }  // '0' for no limit
+    inline void setMemoryCap(size_t cap)     { memoryCap = cap; tt.setMemoryCap(cap); }
+    inline quint64 getNodeCount() const     { return nodeCount; }
+    inline int getBestHome() const          { return bestHome; }  // Most cards home in any position searched
+
+private:
+    // Search stack frame
+    typedef struct _Frame_t
+    {
+        KlondikeState_t st;
+        int moveCnt;
+        int next;
+        KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+    } Frame_t;
+
+    TranspositionTable tt;
+    QVector<Frame_t> stack;
+    quint64 nodeLimit;
+    quint64 nodeCount;
+    int bestHome;
+    size_t memoryCap;
+};
+
+#endif // KLONDIKE_SOLVER_H
@@ -0,0 +1,418 @@
+#include "klondike_state.h"
+
+using namespace std;
+
+
+#define CODE_OF(c)  ((quint8)((c).getCode() & ~CARD_FACE_UP_BIT))
+
+#define PUT_MOVE(st, si, dt, di, n)  \
+    do { KlondikeMove_t &m = pMoves[moveCnt++]; m.srcType = (st); m.srcId = (si); m.dstType = (dt); m.dstId = (di); m.count = (n); } while (0)
+
+
+// Append pile cards to state card array and count its face-down cards; return
+//   new card count, or -1 on overflow or if a face-down card lies above a
+//   face-up one
+static int appendPile(KlondikeState_t &st, int n, Pile *pPile, int &faceDownCnt, bool topFirst = false)
+{
+    int cnt = pPile->getCardCount();
+    int i = 0;
+
+    faceDownCnt = 0;
+    if (n + cnt > CARDS_PER_STD_DECK) return -1;
+
+    for (Card card = pPile->bottomCard(); !card.isNull(); card = pPile->prevCard())
+    {
+        if (!card.isFaceUp() && faceDownCnt++ != i) return -1;
+        st.cards[n++] = CODE_OF(card);
+        i++;
+    }
+    if (topFirst) reverse(st.cards + n - cnt, st.cards + n);
+
+    return n;
+}
+
+// Refill pile from state card array
+static void fillPile(const KlondikeState_t &st, int idx, int cnt, int faceDownCnt, Pile *pPile,
+                     bool topFirst = false)
+{
+    pPile->clear();
+    for (auto i = 0; i < cnt; i++)
+    {
+        Card card = Card::fromCode(st.cards[topFirst? (idx + cnt - 1 - i) : (idx + i)]);
+        if (i >= faceDownCnt) card.flipFaceUp();
+        pPile->push(card);
+    }
+}
+
+// Open 'n' byte gap at 'idx' in card array holding 'total' cards
+static inline void openGap(KlondikeState_t &st, int idx, int n, int total)
+{
+    memmove(&st.cards[idx + n], &st.cards[idx], total - idx);
+}
+
+// Close 'n' byte gap at 'idx' in card array holding 'total' cards; tail zeroed
+static inline void closeGap(KlondikeState_t &st, int idx, int n, int total)
+{
+    memmove(&st.cards[idx], &st.cards[idx + n], total - idx - n);
+    memset(&st.cards[total - n], 0, n);
+}
+
+// Card code may be placed on foundation top code
+static inline bool fitsHome(quint8 code, quint8 homeCode)
+{
+    if (homeCode == KLONDIKE_EMPTY_FOUNDATION) return KCODE_VALUE(code) == ACE;
+
+    return ((code ^ homeCode) & CARD_SUIT_MASK) == 0 && KCODE_VALUE(code) == KCODE_VALUE(homeCode) + 1;
+}
+
+// Card code may be placed on tableau top code ('0' for empty pile)
+static inline bool fitsTableau(quint8 code, quint8 topCode)
+{
+    if (topCode == 0) return KCODE_VALUE(code) == KING;
+
+    return (KCODE_VALUE(topCode) == KCODE_VALUE(code) + 1) && (KCODE_IS_RED(topCode) != KCODE_IS_RED(code));
+}
+
+// Turn up face-down top of tableau pile
+static inline void exposeTableau(KlondikeState_t &st, int pid)
+{
+    if (st.faceDownCount[pid] != 0 && st.faceDownCount[pid] == st.tableauCount[pid]) st.faceDownCount[pid]--;
+}
+
+
+////////////////////////
+// Standard functions
+
+// Capture Klondike table into compact state; returns 'false' if the pile
+//   layout is not Klondike's or a face state cannot be implied by the state
+//   (see 'KlondikeState_t')
+bool KlondikeStateFromPileMap(KlondikeState_t &st, PileMap_t &pileMap)
+{
+    int n = 0;
+    int faceDownCnt;
+
+    memset(&st, 0, sizeof(st));
+
+    if (!PILE_MAP.contains(DECK) || !PILE_MAP.contains(DISCARD) ||
+        PILE_VECTOR(FOUNDATION).size() != KLONDIKE_FOUNDATION_COUNT ||
+        PILE_VECTOR(TABLEAU).size() != KLONDIKE_TABLEAU_COUNT) return false;
+
+    // Stock all face-down and waste all face-up
+    n = appendPile(st, n, PILE_DECK, faceDownCnt);
+    if (n < 0 || faceDownCnt != n) return false;
+    st.stockCount = n;
+    n = appendPile(st, n, PILE_DISCARD, faceDownCnt, true);
+    if (n < 0 || faceDownCnt != 0) return false;
+    st.wasteCount = n - st.stockCount;
+
+    // Tableau
+    for (auto p = 0; p < KLONDIKE_TABLEAU_COUNT; p++)
+    {
+        int start = n;
+        n = appendPile(st, n, PILE(TABLEAU, p), faceDownCnt);
+        if (n < 0) return false;
+        st.tableauCount[p] = n - start;
+        st.faceDownCount[p] = faceDownCnt;
+    }
+
+    // Foundations; only the top card is kept
+    for (auto p = 0; p < KLONDIKE_FOUNDATION_COUNT; p++)
+    {
+        Card card = PILE(FOUNDATION, p)->topCard();
+        st.foundation[p] = card.isNull()? KLONDIKE_EMPTY_FOUNDATION : CODE_OF(card);
+    }
+
+    return true;
+}
+
+// Rebuild Klondike table from compact state; piles must already be registered
+void KlondikeStateToPileMap(const KlondikeState_t &st, PileMap_t &pileMap)
+{
+    int idx = 0;
+
+    // Stock (face-down) and waste (face-up)
+    fillPile(st, idx, st.stockCount, st.stockCount, PILE_DECK);
+    idx += st.stockCount;
+    fillPile(st, idx, st.wasteCount, 0, PILE_DISCARD, true);
+    idx += st.wasteCount;
+
+    // Tableau
+    for (auto p = 0; p < KLONDIKE_TABLEAU_COUNT; p++)
+    {
+        fillPile(st, idx, st.tableauCount[p], st.faceDownCount[p], PILE(TABLEAU, p));
+        idx += st.tableauCount[p];
+    }
+
+    // Foundations; rebuild ascending run up to top card
+    for (auto p = 0; p < KLONDIKE_FOUNDATION_COUNT; p++)
+    {
+        Pile *pPile = PILE(FOUNDATION, p);
+
+        pPile->clear();
+        if (st.foundation[p] == KLONDIKE_EMPTY_FOUNDATION) continue;
+
+        Card top = Card::fromCode(st.foundation[p]);
+        for (auto v = (int)ACE; v <= top.getValue(); v++)
+        {
+            pPile->push(Card(top.getSuit(), (CardValue_t)v, FACE_UP));
+        }
+    }
+}
+
+// Generate every legal move into 'pMoves', which must hold 'KLONDIKE_MAX_MOVES';
+//   returns move count. No ordering or pruning; see 'KlondikeSolver' for that
+int KlondikeStateLegalMoves(const KlondikeState_t &st, KlondikeMove_t *pMoves)
+{
+    int moveCnt = 0;
+    int idx = st.stockCount + st.wasteCount;
+    int runStart[KLONDIKE_TABLEAU_COUNT];  // Index of lowest card of face-up top run
+    quint8 top[KLONDIKE_TABLEAU_COUNT];    // Face-up top code; '0' if pile empty or top face-down
+    bool open[KLONDIKE_TABLEAU_COUNT];     // Pile can take cards
+    quint8 wasteTop = (st.wasteCount != 0)? st.cards[st.stockCount] : 0;
+
+    // Gather pile tops and top runs; a face-down top can only be turned up
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        int fd = st.faceDownCount[t];
+        int end = idx + st.tableauCount[t];
+
+        open[t] = (fd < st.tableauCount[t]) || (st.tableauCount[t] == 0);
+        top[t] = (fd < st.tableauCount[t])? st.cards[end - 1] : 0;
+        if (!open[t]) PUT_MOVE(TABLEAU, t, TABLEAU, t, 1);
+        runStart[t] = end - 1;
+        while (runStart[t] > idx + fd && fitsTableau(st.cards[runStart[t]], st.cards[runStart[t] - 1])) runStart[t]--;
+        idx = end;
+    }
+
+    // To foundations
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++)
+    {
+        for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+        {
+            if (top[t] != 0 && fitsHome(top[t], st.foundation[f])) PUT_MOVE(TABLEAU, t, FOUNDATION, f, 1);
+        }
+        if (wasteTop != 0 && fitsHome(wasteTop, st.foundation[f])) PUT_MOVE(DISCARD, 0, FOUNDATION, f, 1);
+    }
+
+    // Tableau runs; at most one card of a run fits a given pile
+    idx = st.stockCount + st.wasteCount;
+    for (auto s = 0; s < KLONDIKE_TABLEAU_COUNT; s++)
+    {
+        int end = idx + st.tableauCount[s];
+
+        if (top[s] != 0)
+        {
+            for (auto d = 0; d < KLONDIKE_TABLEAU_COUNT; d++)
+            {
+                if (d == s || !open[d]) continue;
+
+                // Card of run with the rank needed; run ranks rise by one per card down
+                int need = (top[d] == 0)? KING : KCODE_VALUE(top[d]) - 1;
+                int i = end - 1 - (need - KCODE_VALUE(top[s]));
+                if (i < runStart[s] || i >= end || !fitsTableau(st.cards[i], top[d])) continue;
+
+                PUT_MOVE(TABLEAU, s, TABLEAU, d, end - i);
+            }
+        }
+        idx = end;
+    }
+
+    // Waste and foundations to tableau
+    for (auto d = 0; d < KLONDIKE_TABLEAU_COUNT; d++)
+    {
+        if (!open[d]) continue;
+
+        if (wasteTop != 0 && fitsTableau(wasteTop, top[d])) PUT_MOVE(DISCARD, 0, TABLEAU, d, 1);
+        for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++)
+        {
+            if (st.foundation[f] != KLONDIKE_EMPTY_FOUNDATION && fitsTableau(st.foundation[f], top[d]))
+            {
+                PUT_MOVE(FOUNDATION, f, TABLEAU, d, 1);
+            }
+        }
+    }
+
+    // Draw or recycle
+    if (st.stockCount != 0) PUT_MOVE(DECK, 0, DISCARD, 0, 1);
+    else if (st.wasteCount != 0) PUT_MOVE(DISCARD, 0, DECK, 0, st.wasteCount);
+
+    return moveCnt;
+}
+
+// Position can never be won; a cheap, conservative test, so a 'false' result
+//   proves nothing
+/* Two tests. First: nothing but draw/recycle is possible, no tableau top is
+ * waiting to be turned up and no stock or waste card can ever be played, so
+ * the table can never change. Second: every
+ * tableau card must leave its pile to be won, and a card can only first move
+ * once all cards above it have, onto a parent (next rank, other colour) that
+ * is exposed, home or in the stock, or home once all lower cards of its suit
+ * can be. Kings and cards already on a parent in a face-up run are let go
+ * freely. Iterating these optimistic rules to a fixed point over card masks
+ * finds cards blocked by dependency cycles, e.g. the 6H over the 4H and both
+ * black 7s in one pile; any such card makes the position hopeless. */
+bool KlondikeStateIsDeadEnd(const KlondikeState_t &st)
+{
+    KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+    CardMask_t homeMask = 0;
+    CardMask_t stockMask = 0;
+    CardMask_t freeMask = 0;
+    CardMask_t movableMask = 0;
+    CardMask_t tableauMask = 0;
+    int start[KLONDIKE_TABLEAU_COUNT];
+    int idx = st.stockCount + st.wasteCount;
+    bool changed;
+
+    if (KlondikeStateIsWon(st)) return false;
+
+    // Stuck table: only draw/recycle left, no flip pending and no stock card
+    //   fits anywhere; a face-down top is never a target
+    int moveCnt = KlondikeStateLegalMoves(st, moves);
+    if (moveCnt == 0 || (moveCnt == 1 && (moves[0].srcType == DECK || moves[0].dstType == DECK)))
+    {
+        bool playable = false;
+        for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT && !playable; t++)
+        {
+            playable = (st.tableauCount[t] != 0 && st.faceDownCount[t] == st.tableauCount[t]);
+        }
+        for (auto i = 0; i < st.stockCount + st.wasteCount && !playable; i++)
+        {
+            quint8 code = st.cards[i];
+            for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT && !playable; f++) playable = fitsHome(code, st.foundation[f]);
+            for (auto t = 0, n = st.stockCount + st.wasteCount; t < KLONDIKE_TABLEAU_COUNT && !playable; t++)
+            {
+                quint8 topCode = (st.tableauCount[t] != 0)? st.cards[n + st.tableauCount[t] - 1] : 0;
+                playable = fitsTableau(code, topCode);
+                n += st.tableauCount[t];
+            }
+        }
+        if (!playable) return true;
+    }
+
+    // Gather card masks
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++)
+    {
+        quint8 code = st.foundation[f];
+        if (code != KLONDIKE_EMPTY_FOUNDATION) homeMask |= ((KCODE_BIT(code) << 1) - 1) & SUIT_MASK(KCODE_SUIT(code));
+    }
+    for (auto i = 0; i < st.stockCount + st.wasteCount; i++) stockMask |= KCODE_BIT(st.cards[i]);
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        start[t] = idx;
+        idx += st.tableauCount[t];
+    }
+    for (auto i = start[0]; i < idx; i++) tableauMask |= KCODE_BIT(st.cards[i]);
+
+    // Grow movable set to a fixed point; each pass walks piles top down
+    do
+    {
+        changed = false;
+        for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+        {
+            for (auto i = start[t] + st.tableauCount[t] - 1; i >= start[t]; i--)
+            {
+                quint8 code = st.cards[i];
+                CardMask_t bit = KCODE_BIT(code);
+                int rank = KCODE_VALUE(code);
+
+                freeMask |= bit; // All cards above can move
+                if (movableMask & bit) continue;
+
+                bool onRun = (i > start[t] + st.faceDownCount[t]) && fitsTableau(code, st.cards[i - 1]);
+                CardMask_t lowerMask = (bit - 1) & SUIT_MASK(KCODE_SUIT(code));
+                CardMask_t parentMask = 0;
+                if (rank != KING)
+                {
+                    int parentShift = rank;  // Parent is one rank up
+                    CardMask_t rankBits = (1ULL << parentShift) | (1ULL << (parentShift + CARDS_PER_STD_SUIT));
+                    parentMask = KCODE_IS_RED(code)? rankBits << (CLUBS * CARDS_PER_STD_SUIT) : rankBits;
+                }
+
+                if (rank == KING || onRun ||
+                    (lowerMask & ~(homeMask | stockMask | movableMask)) == 0 ||
+                    (parentMask & (homeMask | stockMask | freeMask)) != 0)
+                {
+                    movableMask |= bit;
+                    changed = true;
+                }
+                else break; // Cards below stay covered
+            }
+        }
+    } while (changed);
+
+    return (tableauMask & ~movableMask) != 0;
+}
+
+// Apply move to state; move must be legal. As in the engine, a card left
+//   face down on top of a tableau pile stays so until a flip move turns it
+void KlondikeStateApply(KlondikeState_t &st, const KlondikeMove_t &move)
+{
+    int total = KlondikeCardsLeft(st);
+    quint8 run[CARDS_PER_STD_DECK];
+    int n = move.count;
+    int idx;
+
+    if (KMOVE_IS_FLIP(move))
+    {
+        exposeTableau(st, move.srcId);
+        return;
+    }
+
+    // Pick up moving card(s)
+    switch (move.srcType)
+    {
+    case DECK:
+        // Draw; stock top becomes waste top in place
+        st.stockCount--;
+        st.wasteCount++;
+        return;
+
+    case DISCARD:
+        if (move.dstType == DECK)
+        {
+            // Recycle; waste stored top first is already stock order
+            st.stockCount = st.wasteCount;
+            st.wasteCount = 0;
+            return;
+        }
+        run[0] = st.cards[st.stockCount];
+        closeGap(st, st.stockCount, 1, total);
+        st.wasteCount--;
+        total--;
+        break;
+
+    case TABLEAU:
+        idx = KlondikeTableauOffset(st, move.srcId) + st.tableauCount[move.srcId] - n;
+        memcpy(run, &st.cards[idx], n);
+        closeGap(st, idx, n, total);
+        st.tableauCount[move.srcId] -= n;
+        total -= n;
+        break;
+
+    case FOUNDATION:
+        run[0] = st.foundation[move.srcId];
+        st.foundation[move.srcId] = (KCODE_VALUE(run[0]) == ACE)? KLONDIKE_EMPTY_FOUNDATION : run[0] - 1;
+        break;
+
+    default:
+        return;
+    }
+
+    // Drop moving card(s)
+    switch (move.dstType)
+    {
+    case FOUNDATION:
+        st.foundation[move.dstId] = run[0];
+        break;
+
+    case TABLEAU:
+        idx = KlondikeTableauOffset(st, move.dstId) + st.tableauCount[move.dstId];
+        openGap(st, idx, n, total);
+        memcpy(&st.cards[idx], run, n);
+        st.tableauCount[move.dstId] += n;
+        break;
+
+    default:
+        break;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef KLONDIKE_STATE_H
+#define KLONDIKE_STATE_H
+
+#include <cstring>
+#include "klondike.h"
+
+
+#define KLONDIKE_EMPTY_FOUNDATION  (0)  // Foundation top code when empty
+
+
+// Compact Klondike position; plain bytes only, so it may be copied with
+//   memcpy, compared with memcmp and hashed directly
+/* 'cards' holds the stock, waste and tableau piles back-to-back as card codes
+ * with the face-up bit cleared. Stock and tableau piles are stored bottom card
+ * first; the waste is stored top card first so it sits against the stock top,
+ * making a draw or a recycle a pure count change. Face state is implied: stock
+ * cards are face-down, waste cards face-up and the first 'faceDownCount' cards
+ * of each tableau pile face-down. Klondike's rules never leave cards any other
+ * way, so no face state is lost; a table that breaks this is not captured.
+ * Bytes past the last card are always zero. */
+typedef struct _KlondikeState_t
+{
+    quint8 cards[CARDS_PER_STD_DECK];
+    quint8 stockCount;
+    quint8 wasteCount;
+    quint8 tableauCount[KLONDIKE_TABLEAU_COUNT];
+    quint8 faceDownCount[KLONDIKE_TABLEAU_COUNT];
+    quint8 foundation[KLONDIKE_FOUNDATION_COUNT];  // Top card code per foundation
+} KlondikeState_t;
+static_assert(sizeof(KlondikeState_t) <= 128, "KlondikeState_t must fit in two cache lines");
+
+// Single Klondike move; draw is DECK->DISCARD, recycle is DISCARD->DECK and
+//   turning up a face-down tableau top is that pile to itself
+typedef struct _KlondikeMove_t
+{
+    quint8 srcType;  // PileType_t
+    quint8 srcId;
+    quint8 dstType;  // PileType_t
+    quint8 dstId;
+    quint8 count;
+} KlondikeMove_t;
+
+#define KLONDIKE_MAX_MOVES  (128)  // Upper bound on legal moves from one position
+
+#define KMOVE_IS_FLIP(m)  ((m).srcType == TABLEAU && (m).dstType == TABLEAU && (m).srcId == (m).dstId)
+
+#define KCODE_VALUE(c)   ((c) & CARD_VALUE_MASK)
+#define KCODE_SUIT(c)    (((c) & CARD_SUIT_MASK) >> CARD_SUIT_SHIFT)
+#define KCODE_IS_RED(c)  (((c) & (CLUBS << CARD_SUIT_SHIFT)) == 0)
+#define KCODE_BIT(c)     (1ULL << (KCODE_SUIT(c) * CARDS_PER_STD_SUIT + KCODE_VALUE(c) - ACE))  // 'CardMask_t' bit
+
+
+bool KlondikeStateFromPileMap(KlondikeState_t &st, PileMap_t &pileMap);
+void KlondikeStateToPileMap(const KlondikeState_t &st, PileMap_t &pileMap);
+
+inline bool KlondikeStateFromGame(KlondikeState_t &st, Game &game)  { return KlondikeStateFromPileMap(st, game.getPileMap()); }
+inline void KlondikeStateToGame(const KlondikeState_t &st, Game &game)  { KlondikeStateToPileMap(st, game.getPileMap()); game.resync(); }
+
+// Index of first card of tableau pile 'pid' within 'cards'
+inline int KlondikeTableauOffset(const KlondikeState_t &st, int pid)
+{
+    int idx = st.stockCount + st.wasteCount;
+
+    for (auto p = 0; p < pid; p++) idx += st.tableauCount[p];
+
+    return idx;
+}
+
+// Number of cards not yet on foundations
+inline int KlondikeCardsLeft(const KlondikeState_t &st)
+{
+    return KlondikeTableauOffset(st, KLONDIKE_TABLEAU_COUNT);
+}
+
+inline bool KlondikeStateIsWon(const KlondikeState_t &st)  { return KlondikeCardsLeft(st) == 0; }
+
+void KlondikeStateApply(KlondikeState_t &st, const KlondikeMove_t &move);
+int KlondikeStateLegalMoves(const KlondikeState_t &st, KlondikeMove_t *pMoves);
+bool KlondikeStateIsDeadEnd(const KlondikeState_t &st);
+
+inline bool KlondikeStateEqual(const KlondikeState_t &a, const KlondikeState_t &b)
+{
+    return memcmp(&a, &b, sizeof(KlondikeState_t)) == 0;
+}
+
+// 64-bit hash over the raw state bytes
+inline quint64 KlondikeStateHash(const KlondikeState_t &st)
+{
+    const unsigned char *pBytes = (const unsigned char *)&st;
+    quint64 h = 0x9e3779b97f4a7c15ULL;
+    quint64 w;
+    unsigned i;
+
+    for (i = 0; i + sizeof(w) <= sizeof(st); i += sizeof(w))
+    {
+        memcpy(&w, pBytes + i, sizeof(w));
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    for (; i < sizeof(st); i++) h = (h ^ pBytes[i]) * 0x100000001b3ULL;
+
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+#endif // KLONDIKE_STATE_H
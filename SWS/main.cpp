@@ -1,7 +1,6 @@
-#include "klondike.h"
+#include "solitaire.h"
 
 int main(int argc, char *argv[])
 {
-    Klondike(argc, argv);
-    return 0;
+    return Solitaire(argc, argv);
 }
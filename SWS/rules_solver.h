@@ -0,0 +1,160 @@
+#ifndef RULES_SOLVER_H
+#define RULES_SOLVER_H
+
+#include <QVector>
+#include "game.h"
+#include "transposition_table.h"
+
+
+#define RULES_MAX_MOVES             (128)  // Upper bound on candidate moves from one position
+#define RULES_SOLVER_INITIAL_DEPTH  (256)
+
+typedef QVector<GameMove_t> GameMoveList_t;
+
+
+// Depth-first solver for any 'RulesGame' whose rules can generate and play
+//   moves; the search plays moves on a private copy of the game, takes them
+//   back through its undo journal and spots repeated positions by its hash
+/* Besides the 'RulesGame' members, 'Rules' supplies 'genMoves(PileMap_t &,
+ * GameMove_t *)', returning the candidate moves in search order, and
+ * 'playMove(Game &, const GameMove_t &)', playing one move inside the undo
+ * step the solver opens; a move it leaves unplayed is passed over. Each move
+ * should match one command, a flip included, so a solution replays as
+ * commands.
+ * A position is solved once every card is on a foundation. As 'genMoves' may
+ * leave out moves it judges useless, a search that runs out of moves ends
+ * with 'SS_NO_WIN_FOUND' rather than claiming the deal cannot be won. */
+template <class Rules>
+class RulesSolver
+{
+public:
+    RulesSolver(size_t memoryCap = TT_DEFAULT_MEMORY_CAP);
+
+    SolveStatus_t solve(const RulesGame<Rules> &game, GameMoveList_t &solution);
+    SolveStatus_t solveSeed(uint seed, GameMoveList_t &solution, DealVersion_t dealVersion = DEAL_CURRENT);
+
+    inline void setNodeLimit(quint64 limit)  { nodeLimit = limit; }  // '0' for no limit
+    inline void setMemoryCap(size_t cap)     { memoryCap = cap; tt.setMemoryCap(cap); }
+    inline quint64 getNodeCount() const     { return nodeCount; }
+    inline int getBestHome() const          { return bestHome; }  // Most cards home in any position searched
+
+private:
+    // Search stack frame
+    typedef struct _Frame_t
+    {
+        int moveCnt;
+        int next;
+        GameMove_t moves[RULES_MAX_MOVES];
+    } Frame_t;
+
+    TranspositionTable tt;
+    QVector<Frame_t> stack;
+    quint64 nodeLimit;
+    quint64 nodeCount;
+    int bestHome;
+    size_t memoryCap;
+};
+
+
+template <class Rules>
+RulesSolver<Rules>::RulesSolver(size_t memoryCap) : tt(memoryCap)
+{
+    nodeLimit = 0;
+    nodeCount = 0;
+    bestHome = 0;
+    this->memoryCap = memoryCap;
+    stack.reserve(RULES_SOLVER_INITIAL_DEPTH);
+}
+
+// Search for a winning move sequence from the position of 'game'
+template <class Rules>
+SolveStatus_t RulesSolver<Rules>::solve(const RulesGame<Rules> &game, GameMoveList_t &solution)
+{
+    RulesGame<Rules> work(game);
+    int depth = 0;
+
+    solution.clear();
+    tt.clear();
+    nodeCount = 0;
+    bestHome = work.getCardsHome();
+    work.clearJournal();
+
+    if (work.isGameWon()) return SS_SOLVED;
+
+    // Seed stack with root position
+    if (stack.size() < RULES_SOLVER_INITIAL_DEPTH) stack.resize(RULES_SOLVER_INITIAL_DEPTH);
+    stack[0].moveCnt = Rules::genMoves(work.getPileMap(), stack[0].moves);
+    stack[0].next = 0;
+    tt.insert(work.getHash());
+
+    while (depth >= 0)
+    {
+        Frame_t *pFrame = &stack[depth];
+
+        if (pFrame->next == pFrame->moveCnt)
+        {
+            if (depth-- > 0) work.undo(); // Exhausted; back out the move that led here
+            continue;
+        }
+        pFrame->next++;
+
+        // Grow stack within memory cap
+        if (depth + 1 == stack.size())
+        {
+            size_t stackBytes = (size_t)stack.size() * 2 * sizeof(Frame_t);
+            if (stackBytes + tt.getMemoryUsage() > memoryCap) return SS_MEMORY_LIMIT;
+            stack.resize(stack.size() * 2);
+            pFrame = &stack[depth];
+        }
+
+        // Play move as one undo step; one that changed nothing leaves no step
+        //   to undo, and is no new position
+        int journalPos = work.getJournalPos();
+        work.beginStep();
+        Rules::playMove(work, pFrame->moves[pFrame->next - 1]);
+        work.endStep();
+        if (work.getJournalPos() == journalPos) continue;
+
+        if (work.getCardsHome() > bestHome) bestHome = work.getCardsHome();
+        if (work.isGameWon())
+        {
+            for (auto d = 0; d <= depth; d++) solution.append(stack[d].moves[stack[d].next - 1]);
+            return SS_SOLVED;
+        }
+
+        switch (tt.insert(work.getHash()))
+        {
+        case TT_PRESENT:
+            work.undo();
+            continue;
+        case TT_FULL:
+            return SS_MEMORY_LIMIT;
+        default:
+            break;
+        }
+
+        if (nodeLimit != 0 && nodeCount >= nodeLimit) return SS_NODE_LIMIT;
+        nodeCount++;
+
+        Frame_t *pChild = &stack[depth + 1];
+        pChild->moveCnt = Rules::genMoves(work.getPileMap(), pChild->moves);
+        pChild->next = 0;
+        depth++;
+    }
+
+    return SS_NO_WIN_FOUND; // Generators prune moves, so this is no proof
+}
+
+// Search from the opening deal for a deck seed
+template <class Rules>
+SolveStatus_t RulesSolver<Rules>::solveSeed(uint seed, GameMoveList_t &solution, DealVersion_t dealVersion)
+{
+    RulesGame<Rules> game(seed, dealVersion);
+
+    solution.clear();
+    if (game.setUp() != GS_OK) return SS_ERROR;
+
+    return solve(game, solution);
+}
+
+#endif // RULES_SOLVER_H
@@ -0,0 +1,644 @@
+#include <QDebug>
+#include <cerrno>
+#include <cstdarg>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+#include "klondike_rules.h"
+#include "freecell_rules.h"
+#include "spider_rules.h"
+
+using namespace std;
+
+
+// Per-variant game operations; games are kept as 'Game *' in the pools
+typedef struct _VariantOps_t
+{
+    Game * (*create)(uint seed);
+    CmdError_t (*command)(Game *pGame, Cdb_t &cdb);
+    void (*destroy)(Game *pGame);
+} VariantOps_t;
+
+// New game of variant, set up and dealt; 'nullptr' if the table cannot be set up
+template <class Rules>
+static Game * createGame(uint seed)
+{
+    RulesGame<Rules> *pGame = new RulesGame<Rules>(seed);
+
+    if (pGame->setUp() != GS_OK)
+    {
+        delete pGame;
+        return nullptr;
+    }
+
+    return pGame;
+}
+
+// Run command through the variant's rules
+template <class Rules>
+static CmdError_t gameCommand(Game *pGame, Cdb_t &cdb)
+{
+    return static_cast<RulesGame<Rules> *>(pGame)->processCommand(cdb);
+}
+
+// Free game as the type it was created as
+template <class Rules>
+static void destroyGame(Game *pGame)
+{
+    delete static_cast<RulesGame<Rules> *>(pGame);
+}
+
+// By 'Variant_t'
+static const VariantOps_t variantOps[] = {
+    {createGame<KlondikeRules>, gameCommand<KlondikeRules>, destroyGame<KlondikeRules>},
+    {createGame<FreeCellRules>, gameCommand<FreeCellRules>, destroyGame<FreeCellRules>},
+    {createGame<Spider1Rules>,  gameCommand<Spider1Rules>,  destroyGame<Spider1Rules>},
+    {createGame<Spider2Rules>,  gameCommand<Spider2Rules>,  destroyGame<Spider2Rules>},
+    {createGame<Spider4Rules>,  gameCommand<Spider4Rules>,  destroyGame<Spider4Rules>}
+};
+
+
+// Line starts with word 'pVerb'
+static inline bool isVerb(const char *pLine, const char *pVerb)
+{
+    int len = strlen(pVerb);
+
+    return strncmp(pLine, pVerb, len) == 0 && (pLine[len] == '\0' || pLine[len] == ' ');
+}
+
+// Send error only means the socket is full for now
+static inline bool isRetryError(int err)
+{
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+}
+
+// Send what the socket takes now and keep the rest with the connection, behind
+//   any output already kept; returns 'true' if kept output began, so the event
+//   loop must poll for room. Output to a client that is gone is dropped, as the
+//   event loop will see the hang-up.
+static bool sendOrKeep(ServerConn_t &conn, const char *pBuf, int len)
+{
+    lock_guard<mutex> guard(conn.outLock);
+
+    if (!conn.out.empty())
+    {
+        conn.out.insert(conn.out.end(), pBuf, pBuf + len);
+        return false;
+    }
+
+    ssize_t n = send(conn.fd, pBuf, len, 0);
+    if (n == len || (n < 0 && !isRetryError(errno))) return false;
+    if (n > 0)
+    {
+        pBuf += n;
+        len -= n;
+    }
+    conn.out.insert(conn.out.end(), pBuf, pBuf + len);
+    conn.outWait = true;
+
+    return true;
+}
+
+
+////////////////////////////////
+// ServerWorker class methods
+
+ServerWorker::ServerWorker(int sessionCount, int wakeFd) : queue(SERVER_QUEUE_DEPTH), sessions(sessionCount)
+{
+    head = 0;
+    tail = 0;
+    idle = false;
+    waitRoom = false;
+    quit = false;
+    this->wakeFd = wakeFd;
+
+    // Chain all session slots free
+    for (auto s = 0; s < sessionCount; s++)
+    {
+        sessions[s].pGame = nullptr;
+        sessions[s].variant = INVALID_VARIANT;
+        sessions[s].pConn = nullptr;
+        sessions[s].nextFree = (s + 1 < sessionCount)? s + 1 : -1;
+    }
+    freeSession = (sessionCount > 0)? 0 : -1;
+    for (auto &pool : gamePool) pool.reserve(sessionCount);
+
+    outLen = 0;
+    pOutConn = nullptr;
+}
+
+ServerWorker::~ServerWorker()
+{
+    for (auto &session : sessions)
+    {
+        if (session.pGame != nullptr) variantOps[session.variant].destroy(session.pGame);
+    }
+    for (auto v = 0; v < INVALID_VARIANT; v++)
+    {
+        for (auto pGame : gamePool[v]) variantOps[v].destroy(pGame);
+    }
+}
+
+// Queue request line ('len' of '-1' for hang-up); returns 'false' if the queue
+//   is full, and the event loop is woken once there is room. Only 'wait' waits
+//   for room, for the hang-ups posted as the server stops.
+bool ServerWorker::post(ServerConn_t *pConn, const char *pLine, int len, bool wait)
+{
+    unique_lock<mutex> guard(lock);
+
+    if (wait) notFull.wait(guard, [this] { return head - tail < SERVER_QUEUE_DEPTH; });
+    else if (head - tail == SERVER_QUEUE_DEPTH)
+    {
+        waitRoom = true;
+        return false;
+    }
+    ServerRequest_t &req = queue[head % SERVER_QUEUE_DEPTH];
+    req.pConn = pConn;
+    req.len = len;
+    if (len > 0) memcpy(req.line, pLine, len);
+    head++;
+    bool wake = idle;
+    guard.unlock();
+
+    if (wake) notEmpty.notify_one();
+
+    return true;
+}
+
+// Run what is queued, then stop the thread
+void ServerWorker::finish()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        quit = true;
+    }
+    notEmpty.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+// Worker thread; runs queued requests in batches, replies written per batch
+void ServerWorker::workerLoop()
+{
+    quint64 end;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            while (!quit && head == tail)
+            {
+                idle = true;
+                notEmpty.wait(guard);
+                idle = false;
+            }
+            if (head == tail) return;
+            end = head;
+        }
+
+        // Slots up to 'end' are not reused until 'tail' passes them
+        for (auto r = tail; r < end; r++) handleRequest(queue[r % SERVER_QUEUE_DEPTH]);
+        flush();
+
+        bool wake;
+        {
+            lock_guard<mutex> guard(lock);
+            tail = end;
+            wake = waitRoom;
+            waitRoom = false;
+        }
+        notFull.notify_one();
+        if (wake) wakeLoop();
+    }
+}
+
+// Parse and run one request
+void ServerWorker::handleRequest(ServerRequest_t &req)
+{
+    char *pLine = req.line;
+    char *pEnd;
+    unsigned long sid;
+
+    if (req.len < 0)
+    {
+        hangUp(req.pConn);
+        return;
+    }
+    pLine[req.len] = '\0';
+    while (*pLine == ' ') pLine++;
+
+    if (isVerb(pLine, "open")) openSession(req.pConn, pLine + 4);
+    else if (isVerb(pLine, "close"))
+    {
+        sid = strtoul(pLine + 5, &pEnd, 10);
+        if (pEnd == pLine + 5) reply(req.pConn, "err bad request\n");
+        else closeSession(req.pConn, (int)sid);
+    }
+    else if (*pLine >= '0' && *pLine <= '9')
+    {
+        sid = strtoul(pLine, &pEnd, 10);
+        runCommand(req.pConn, (int)sid, pEnd, req.line + req.len - pEnd);
+    }
+    else if (*pLine != '\0') reply(req.pConn, "err bad request\n");
+}
+
+// Start session of a variant from the pool; a pooled game is re-dealt in place
+void ServerWorker::openSession(ServerConn_t *pConn, const char *pArgs)
+{
+    char name[16] = "klondike";
+    unsigned seed = INVALID_SEED;
+    Variant_t variant;
+    Game *pGame;
+
+    if (sscanf(pArgs, "%15s %u", name, &seed) == 1 && strspn(name, "0123456789") == strlen(name))
+    {
+        // Seed only
+        seed = strtoul(name, nullptr, 10);
+        strcpy(name, "klondike");
+    }
+    variant = FindVariant(name);
+    if (variant == INVALID_VARIANT)
+    {
+        reply(pConn, "err bad variant\n");
+        return;
+    }
+    if (freeSession < 0)
+    {
+        reply(pConn, "err session limit\n");
+        return;
+    }
+
+    if (gamePool[variant].empty()) pGame = variantOps[variant].create(seed);
+    else
+    {
+        pGame = gamePool[variant].back();
+        gamePool[variant].pop_back();
+        pGame->reset(seed);
+    }
+    if (pGame == nullptr)
+    {
+        reply(pConn, "err set up failed\n");
+        return;
+    }
+
+    int sid = freeSession;
+    ServerSession_t &session = sessions[sid];
+    freeSession = session.nextFree;
+    session.pGame = pGame;
+    session.variant = variant;
+    session.pConn = pConn;
+
+    reply(pConn, "ok %d %s %u\n", sid, GetVariantName(variant), pGame->getDeckSeed());
+}
+
+// End session; its game goes back to the pool
+void ServerWorker::closeSession(ServerConn_t *pConn, int sid)
+{
+    if (!isOwnSession(pConn, sid))
+    {
+        reply(pConn, "err bad session\n");
+        return;
+    }
+
+    ServerSession_t &session = sessions[sid];
+    gamePool[session.variant].push_back(session.pGame);
+    session.pGame = nullptr;
+    session.pConn = nullptr;
+    session.nextFree = freeSession;
+    freeSession = sid;
+
+    reply(pConn, "ok %d\n", sid);
+}
+
+// Run game command on session and report the result
+void ServerWorker::runCommand(ServerConn_t *pConn, int sid, const char *pCmd, int len)
+{
+    Cdb_t cdb;
+    CmdError_t status;
+
+    if (!isOwnSession(pConn, sid))
+    {
+        reply(pConn, "err bad session\n");
+        return;
+    }
+
+    // Validation reports any missing args; hints need the console game
+    Game *pGame = sessions[sid].pGame;
+    status = console.tokenize(cdb, pCmd, len);
+    if (status == CS_OK || status == CS_MISSING_ARGS)
+    {
+        if (cdb.cmdId == _HINT_CMD) status = CS_BAD_CMD;
+        else status = variantOps[sessions[sid].variant].command(pGame, cdb);
+    }
+
+    reply(pConn, "%d %d %d %d/%d %016llx\n", sid, status, pGame->getState(), pGame->getCardsHome(),
+          pGame->getCardCount(), (unsigned long long)pGame->getHash());
+}
+
+// Connection gone; end its sessions, drop its replies, then close and free it
+void ServerWorker::hangUp(ServerConn_t *pConn)
+{
+    for (auto s = 0; s < (int)sessions.size(); s++)
+    {
+        if (sessions[s].pGame != nullptr && sessions[s].pConn == pConn)
+        {
+            gamePool[sessions[s].variant].push_back(sessions[s].pGame);
+            sessions[s].pGame = nullptr;
+            sessions[s].pConn = nullptr;
+            sessions[s].nextFree = freeSession;
+            freeSession = s;
+        }
+    }
+    if (pOutConn == pConn)
+    {
+        outLen = 0;
+        pOutConn = nullptr;
+    }
+    close(pConn->fd);
+    delete pConn;
+}
+
+// Session is open and was opened on this connection
+bool ServerWorker::isOwnSession(ServerConn_t *pConn, int sid)
+{
+    return sid >= 0 && sid < (int)sessions.size() && sessions[sid].pGame != nullptr && sessions[sid].pConn == pConn;
+}
+
+// Buffer reply line; replies are written when the connection changes, the
+//   buffer fills or the batch ends
+void ServerWorker::reply(ServerConn_t *pConn, const char *pFormat, ...)
+{
+    va_list args;
+
+    if (pConn != pOutConn || outLen >= SERVER_FLUSH_BYTES) flush();
+    pOutConn = pConn;
+
+    va_start(args, pFormat);
+    outLen += vsnprintf(outBuf + outLen, sizeof(outBuf) - outLen, pFormat, args);
+    va_end(args);
+}
+
+// Write buffered replies without waiting; what the socket will not take is
+//   left for the event loop to send
+void ServerWorker::flush()
+{
+    if (outLen != 0 && sendOrKeep(*pOutConn, outBuf, outLen)) wakeLoop();
+    outLen = 0;
+}
+
+// Have the event loop look at its connections again; a full pipe is already
+//   waking it
+void ServerWorker::wakeLoop()
+{
+    if (write(wakeFd, "w", 1) < 0 && !isRetryError(errno)) qWarning() << "Cannot wake server loop";
+}
+
+
+////////////////////////////////
+// GameServer class methods
+
+GameServer::GameServer(int workerCount, int sessionCount)
+{
+    if (workerCount < 1) workerCount = thread::hardware_concurrency();
+    if (workerCount < 1) workerCount = 1;
+
+    // Wake pipe never blocks a worker; a full pipe wakes the loop all the same
+    if (pipe(wakeFd) != 0) wakeFd[0] = wakeFd[1] = -1;
+    for (auto fd : wakeFd)
+    {
+        if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    for (auto w = 0; w < workerCount; w++) workers.push_back(new ServerWorker(sessionCount, wakeFd[1]));
+    listenFd = -1;
+    stopping = false;
+    nextWorker = 0;
+    path[0] = '\0';
+}
+
+GameServer::~GameServer()
+{
+    for (auto pWorker : workers) delete pWorker;
+    if (listenFd >= 0) close(listenFd);
+    if (path[0] != '\0') unlink(path);
+    if (wakeFd[0] >= 0)
+    {
+        close(wakeFd[0]);
+        close(wakeFd[1]);
+    }
+}
+
+// Bind and listen on socket path, replacing any stale socket file
+bool GameServer::listen(const char *pPath)
+{
+    sockaddr_un addr;
+
+    if (wakeFd[0] < 0 || strlen(pPath) >= sizeof(addr.sun_path)) return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, pPath);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+    unlink(pPath);
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(listenFd, SOMAXCONN) != 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+    strcpy(path, pPath);
+
+    return true;
+}
+
+// Event loop; returns once 'stop' is called, after the workers have finished
+void GameServer::run()
+{
+    vector<pollfd> pfds;
+    vector<ServerConn_t *> conns;  // By 'pfds' index; first two are the wake pipe and listener
+    char drain[64];
+
+    if (listenFd < 0) return;
+    signal(SIGPIPE, SIG_IGN); // Writes to a closed client fail instead
+
+    for (auto pWorker : workers) pWorker->start();
+    pfds.push_back({wakeFd[0], POLLIN, 0});
+    pfds.push_back({listenFd, POLLIN, 0});
+    conns.resize(2, nullptr);
+
+    for (;;)
+    {
+        bool woken = false;
+
+        if (poll(pfds.data(), pfds.size(), -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Stopped, or a worker has queue room or replies kept for the loop to send
+        if (pfds[0].revents != 0)
+        {
+            while (read(wakeFd[0], drain, sizeof(drain)) > 0) continue;
+            if (stopping) break;
+            woken = true;
+        }
+
+        // New connections; each is pinned to the next worker in turn
+        if (pfds[1].revents & POLLIN)
+        {
+            int fd;
+            while ((fd = accept(listenFd, nullptr, nullptr)) >= 0)
+            {
+                ServerConn_t *pConn = new ServerConn_t;
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                pConn->fd = fd;
+                pConn->worker = nextWorker;
+                pConn->inLen = 0;
+                pConn->lineLen = 0;
+                pConn->stalled = false;
+                pConn->closed = false;
+                pConn->outWait = false;
+                pfds.push_back({fd, POLLIN, 0});
+                conns.push_back(pConn);
+                nextWorker = (nextWorker + 1) % workers.size();
+            }
+        }
+
+        // Connections with events, or all of them once woken; one whose hang-up
+        //   is posted belongs to its worker from then on
+        for (auto c = 2; c < (int)pfds.size(); c++)
+        {
+            ServerConn_t &conn = *conns[c];
+            short revents = pfds[c].revents;
+            bool handedOver = false;
+
+            if (revents == 0 && !woken) continue;
+            if (revents & POLLOUT) sendPending(conn);
+            if ((pfds[c].events & POLLIN) && (revents & (POLLIN | POLLHUP | POLLERR))) handedOver = readConnection(conn);
+            else if (revents & (POLLHUP | POLLERR | POLLNVAL))
+            {
+                conn.closed = true;
+                handedOver = postLines(conn);
+            }
+            else if (woken && conn.stalled) handedOver = postLines(conn);
+
+            if (handedOver)
+            {
+                pfds[c] = pfds.back();
+                pfds.pop_back();
+                conns[c] = conns.back();
+                conns.pop_back();
+                c--;
+                continue;
+            }
+
+            // Nothing to poll for leaves the socket out until a worker wakes the loop
+            pfds[c].events = connEvents(conn);
+            pfds[c].fd = (pfds[c].events != 0)? conn.fd : -1;
+        }
+    }
+
+    // Drop remaining connections and let workers drain
+    for (auto c = 2; c < (int)pfds.size(); c++) workers[conns[c]->worker]->post(conns[c], nullptr, -1, true);
+    for (auto pWorker : workers) pWorker->finish();
+}
+
+// Break the event loop; may be called from any thread
+void GameServer::stop()
+{
+    stopping = true;
+    if (write(wakeFd[1], "x", 1) < 0 && !isRetryError(errno)) qWarning() << "Cannot stop server";
+}
+
+// Read what the connection's input buffer has room for and post its complete
+//   lines; '\r' and anything past 'SERVER_LINE_MAX' in a line are dropped.
+//   Returns 'true' once the connection is closed and handed to its worker.
+bool GameServer::readConnection(ServerConn_t &conn)
+{
+    char *pRead = conn.in + conn.inLen;
+    ssize_t n = recv(conn.fd, pRead, SERVER_IN_BYTES - conn.inLen, 0);
+
+    if (n < 0 && isRetryError(errno)) return false;
+    if (n <= 0) conn.closed = true;
+
+    // Filter in place; writes never pass reads
+    for (auto i = 0; i < n; i++)
+    {
+        char c = pRead[i];
+        if (c == '\n')
+        {
+            conn.in[conn.inLen++] = c;
+            conn.lineLen = 0;
+        }
+        else if (c != '\r' && conn.lineLen < SERVER_LINE_MAX - 1)
+        {
+            conn.in[conn.inLen++] = c;
+            conn.lineLen++;
+        }
+    }
+
+    return postLines(conn);
+}
+
+// Post complete input lines, then the hang-up of a closed connection, to its
+//   worker; what a full queue will not take stays in 'in' and the connection
+//   is stalled until the worker has room. Returns 'true' once the hang-up is
+//   posted, after which the connection must not be touched.
+bool GameServer::postLines(ServerConn_t &conn)
+{
+    ServerWorker *pWorker = workers[conn.worker];
+    int start = 0;
+
+    conn.stalled = false;
+    for (auto i = 0; i < conn.inLen && !conn.stalled; i++)
+    {
+        if (conn.in[i] != '\n') continue;
+        if (pWorker->post(&conn, conn.in + start, i - start)) start = i + 1;
+        else conn.stalled = true;
+    }
+    conn.inLen -= start;
+    memmove(conn.in, conn.in + start, conn.inLen);
+
+    if (!conn.closed || conn.stalled) return false;
+    if (pWorker->post(&conn, nullptr, -1)) return true;
+    conn.stalled = true;
+
+    return false;
+}
+
+// Send kept replies the socket now has room for
+void GameServer::sendPending(ServerConn_t &conn)
+{
+    lock_guard<mutex> guard(conn.outLock);
+    ssize_t n = send(conn.fd, conn.out.data(), conn.out.size(), 0);
+
+    if (n > 0) conn.out.erase(conn.out.begin(), conn.out.begin() + n);
+    else if (n < 0 && !isRetryError(errno)) conn.out.clear(); // Client gone; its hang-up follows
+    if (conn.out.empty()) conn.outWait = false;
+}
+
+// Poll events for a connection: room for kept replies, and input unless the
+//   connection is stalled or has 'SERVER_OUT_MAX' replies unsent; none once
+//   it is closed
+short GameServer::connEvents(ServerConn_t &conn)
+{
+    short events = 0;
+    bool outFull = false;
+
+    if (conn.closed) return 0;
+    {
+        lock_guard<mutex> guard(conn.outLock);
+        if (conn.outWait) events |= POLLOUT;
+        outFull = (conn.out.size() >= SERVER_OUT_MAX);
+    }
+    if (!conn.stalled && !outFull) events |= POLLIN;
+
+    return events;
+}
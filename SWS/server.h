@@ -0,0 +1,155 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "game.h"
+#include "variant.h"
+
+
+#define SERVER_LINE_MAX          (CONSOLE_LINE_MAX)  // Longest request line kept; excess is discarded
+#define SERVER_QUEUE_DEPTH       (1024)              // Requests queued per worker
+#define SERVER_DEFAULT_SESSIONS  (4096)              // Session slots per worker
+#define SERVER_IN_BYTES          (8 * 1024)          // Input held per connection while its worker is busy
+#define SERVER_OUT_MAX           (64 * 1024)         // Unsent reply bytes past which a connection's input is left unread
+#define SERVER_FLUSH_BYTES       (16 * 1024)         // Worker reply buffer flush point
+
+
+// Connection; made by the event loop on accept and handed over with its
+//   hang-up to its worker, which closes and frees it
+typedef struct _ServerConn_t
+{
+    int fd;
+    int worker;                // Worker running this connection's requests
+
+    // Input; event loop only
+    int inLen;                 // Bytes in 'in' not yet posted; lines end in '\n'
+    int lineLen;               // Bytes of the partial line ending 'in'
+    bool stalled;              // Worker queue was full; lines wait in 'in'
+    bool closed;               // Peer gone; hang-up waits to be posted
+    char in[SERVER_IN_BYTES];
+
+    // Output; written by the worker, and by the event loop once the socket has room
+    std::mutex outLock;        // Guards 'out' and 'outWait'
+    std::vector<char> out;     // Reply bytes the socket would not take yet
+    bool outWait;              // 'out' is not empty
+} ServerConn_t;
+
+// Queued request: a line from a connection, or its hang-up
+typedef struct _ServerRequest_t
+{
+    ServerConn_t *pConn;
+    int len;  // Line length; '-1' for hang-up
+    char line[SERVER_LINE_MAX];
+} ServerRequest_t;
+
+// Game session slot
+typedef struct _ServerSession_t
+{
+    Game *pGame;            // 'nullptr' if slot is free
+    Variant_t variant;
+    ServerConn_t *pConn;    // Owning connection
+    int nextFree;           // Next free slot; '-1' for none
+} ServerSession_t;
+
+
+// Worker thread; runs the requests of the connections assigned to it and owns
+//   their sessions, so games are never shared between threads
+class ServerWorker
+{
+public:
+    ServerWorker(int sessionCount, int wakeFd);
+    ~ServerWorker();
+
+    bool post(ServerConn_t *pConn, const char *pLine, int len, bool wait = false);
+    inline void start()  { thread = std::thread(&ServerWorker::workerLoop, this); }
+    void finish();
+
+private:
+    void workerLoop();
+    void handleRequest(ServerRequest_t &req);
+    void openSession(ServerConn_t *pConn, const char *pArgs);
+    void closeSession(ServerConn_t *pConn, int sid);
+    void runCommand(ServerConn_t *pConn, int sid, const char *pCmd, int len);
+    void hangUp(ServerConn_t *pConn);
+    bool isOwnSession(ServerConn_t *pConn, int sid);
+    void reply(ServerConn_t *pConn, const char *pFormat, ...);
+    void flush();
+    void wakeLoop();
+
+    // Queue; slots between 'tail' and 'head' are waiting or being run
+    std::vector<ServerRequest_t> queue;
+    quint64 head;
+    quint64 tail;
+    std::mutex lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;  // Only waited on by a final hang-up
+    bool idle;      // Worker waiting on 'notEmpty'; only then is it woken
+    bool waitRoom;  // A post found the queue full; the event loop is woken once there is room
+    bool quit;
+    int wakeFd;     // Event loop's wake pipe
+    std::thread thread;
+
+    // Sessions and idle games by variant; owned by the worker thread
+    std::vector<ServerSession_t> sessions;
+    int freeSession;
+    std::vector<Game *> gamePool[INVALID_VARIANT];
+    GameConsole console;  // Command tokenizer
+
+    // Replies waiting to be written to 'pOutConn'
+    char outBuf[SERVER_FLUSH_BYTES + SERVER_LINE_MAX];
+    int outLen;
+    ServerConn_t *pOutConn;
+};
+
+
+// Multi-session game server on a Unix domain socket
+/* One event loop thread accepts connections and splits their input into lines;
+ * each connection is pinned to a worker thread that runs its requests in order
+ * and writes the replies. Sockets are non-blocking and nothing waits on a slow
+ * client: replies the socket will not take are kept with the connection and
+ * sent by the event loop when it has room, and a connection whose worker queue
+ * is full, or whose unsent replies pass 'SERVER_OUT_MAX', is not read until
+ * that clears, leaving the kernel to push back on the client. Requests are one
+ * line each:
+ *
+ *   open [variant] [seed]    ->  ok <sid> <variant> <seed>
+ *   <sid> <game command>     ->  <sid> <status> <state> <home>/<cards> <hash>
+ *   close <sid>              ->  ok <sid>
+ *
+ * Game commands are those of the console game, parsed into a 'Cdb_t' and run
+ * through the variant's rules; 'status' is the 'CmdError_t' and 'state' the
+ * 'GameState_t' after it. A session belongs to the connection that opened it
+ * and ends with it. Failed requests get 'err <reason>'. Closed sessions keep
+ * their game for the next 'open' of the variant, which re-deals it in place,
+ * so once the pools are warm sessions come and go without heap allocation. */
+class GameServer
+{
+public:
+    GameServer(int workerCount = 0, int sessionCount = SERVER_DEFAULT_SESSIONS);  // '0' workers for one per hardware thread
+    ~GameServer();
+
+    bool listen(const char *pPath);
+    void run();
+    void stop();
+
+    inline int getWorkerCount() const  { return workers.size(); }
+
+private:
+    bool readConnection(ServerConn_t &conn);
+    bool postLines(ServerConn_t &conn);
+    void sendPending(ServerConn_t &conn);
+    short connEvents(ServerConn_t &conn);
+
+    std::vector<ServerWorker *> workers;
+    int listenFd;
+    int wakeFd[2];  // Self-pipe; workers write to have the loop look at stalled connections, 'stop' to end it
+    std::atomic<bool> stopping;
+    int nextWorker;
+    char path[108];
+};
+
+#endif // SERVER_H
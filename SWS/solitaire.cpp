@@ -0,0 +1,228 @@
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <chrono>
+#include "solitaire.h"
+#include "klondike_hint.h"
+#ifdef Q_OS_UNIX
+#include "server.h"
+#endif
+#include "klondike_rules.h"
+#include "freecell_rules.h"
+#include "spider_rules.h"
+
+using namespace std;
+
+
+// Hint text for a Klondike move, e.g. "move t3 f0" or "flip t3"
+static QString moveText(const KlondikeMove_t &move)
+{
+    static const char pileLetter[] = "dswfct";
+
+    if (KMOVE_IS_FLIP(move)) return QString("flip t%1").arg(move.srcId);
+
+    return QString("move %1%2 %3%4").arg(QChar(pileLetter[move.srcType])).arg(move.srcId)
+                                    .arg(QChar(pileLetter[move.dstType])).arg(move.dstId);
+}
+
+// Game loop for one variant; with 'render' off commands are replayed headless
+//   and only the final table, hash and timing are printed. Hints need
+//   'pHintEngine', which only Klondike has.
+template <class Rules>
+static int gameLoop(uint gameSeed, DealVersion_t dealVersion, GameConsole &console, bool render,
+                    KlondikeHintEngine *pHintEngine)
+{
+    static const char *stateStr[] = {"in progress", "error", "won", "over"};
+    Cdb_t cdb;
+    CmdError_t cmdStatus;
+    int cmdCount = 0;
+    int rejectCount = 0;
+    KlondikeHint_t hint;
+
+    // Create game control object
+    RulesGame<Rules> game(gameSeed, dealVersion);
+    if (render)
+    {
+        qDebug() << "... Game object instantiated";
+        qDebug() << "... Game seed:" << game.getDeckSeed();
+        qDebug() << "... Deal version:" << game.getDealVersion();
+    }
+
+    // Init game piles and deal
+    if (game.setUp() != GS_OK)
+    {
+        qWarning() << "Cannot set up game table";
+        return 1;
+    }
+    if (render) qDebug() << "... Piles registered and cards dealt";
+
+    // Game loop
+    auto start = chrono::steady_clock::now();
+    while (!game.isGameFinished())
+    {
+        if (render) game.print(console); // Print table
+        cmdStatus = console.collectInput(cdb); // Collect input
+        if (cmdStatus == CS_END_OF_INPUT) break;
+
+        // Handle command; validation reports any missing args
+        if (cmdStatus == CS_OK || cmdStatus == CS_MISSING_ARGS)
+        {
+            if (cdb.cmdId == _QUIT_CMD) break;
+            if (cdb.cmdId == _CLEAR_CMD) console.invalidate();
+            if (cdb.cmdId == _HINT_CMD && render)
+            {
+                if (pHintEngine == nullptr) qInfo() << "Hint: not available for this game";
+                else if (!pHintEngine->hint(game, hint) || hint.moveWins == 0) qInfo() << "Hint: no winning line found";
+                else qInfo().noquote() << QString("Hint: %1 (win chance ~%2%, %3 samples)").arg(moveText(hint.move))
+                                          .arg(qRound(hint.winChance * 100)).arg(hint.samples);
+            }
+            cmdStatus = game.processCommand(cdb);
+        }
+        cmdCount++;
+        if (cmdStatus != CS_OK)
+        {
+            rejectCount++;
+            if (render) qDebug() << "... Command rejected:" << cmdStatus;
+        }
+    }
+    auto usec = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+    // Final state
+    if (!render)
+    {
+        game.markAllDirty();
+        console.setRenderMode(RENDER_FULL);
+        game.print(console);
+        qInfo().noquote() << QString("state: %1; %2/%3 cards home; %4 commands (%5 rejected); hash %6; %7 us")
+                             .arg(stateStr[game.getState()]).arg(game.getCardsHome()).arg(game.getCardCount())
+                             .arg(cmdCount).arg(rejectCount)
+                             .arg(game.getHash(), 16, 16, QChar('0')).arg((qint64)usec);
+    }
+    else
+    {
+        if (game.isGameFinished()) game.print(console);
+        if (game.isGameWon()) qInfo() << "Game won";
+        else if (game.getState() == GAME_OVER) qInfo() << "Game over: no winning line remains";
+        qDebug() << "... Game loop exited";
+    }
+
+    return 0;
+}
+
+
+////////////////////////
+// Standard functions
+
+// Solitaire console game entry; runs the game loop of the selected variant, or
+//   with '--serve' hosts game sessions for clients on a local socket (Unix
+//   only)
+int Solitaire(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    bool gameSeedOk;
+    uint gameSeed = 0;
+    FILE *inFile = stdin;
+    KlondikeHintEngine hintEngine;
+    int status;
+
+    // Set up game app
+    const QCommandLineOption seedOpt = SetGameAppInfo("Solitaire", "2.1", "SWS solitaire console game", parser);
+    const QCommandLineOption variantOpt = AddVariantOption(parser);
+    const QCommandLineOption dealOpt = AddDealVersionOption(parser);
+    const QCommandLineOption renderOpt = AddRenderModeOption(parser);
+    const QCommandLineOption scriptOpt(QStringList() << "script",
+        QCoreApplication::translate("main", "Read commands from file instead of stdin."),
+        QCoreApplication::translate("main", "file"));
+    const QCommandLineOption noRenderOpt(QStringList() << "no-render",
+        QCoreApplication::translate("main", "Run commands without drawing; print final state, hash and timing."));
+#ifdef Q_OS_UNIX
+    const QCommandLineOption serveOpt(QStringList() << "serve",
+        QCoreApplication::translate("main", "Serve game sessions on a Unix domain socket instead of playing."),
+        QCoreApplication::translate("main", "socket"));
+    const QCommandLineOption workerOpt(QStringList() << "workers",
+        QCoreApplication::translate("main", "Server worker thread count (default one per hardware thread)."),
+        QCoreApplication::translate("main", "count"), "0");
+    const QCommandLineOption sessionOpt(QStringList() << "sessions",
+        QCoreApplication::translate("main", "Server session slots per worker."),
+        QCoreApplication::translate("main", "count"), QString::number(SERVER_DEFAULT_SESSIONS));
+#endif
+    parser.addOption(scriptOpt);
+    parser.addOption(noRenderOpt);
+#ifdef Q_OS_UNIX
+    parser.addOption(serveOpt);
+    parser.addOption(workerOpt);
+    parser.addOption(sessionOpt);
+#endif
+
+    // Parse and handle
+    parser.process(app);
+#ifdef Q_OS_UNIX
+    if (parser.isSet(serveOpt))
+    {
+        GameServer server(parser.value(workerOpt).toInt(), parser.value(sessionOpt).toInt());
+        if (!server.listen(parser.value(serveOpt).toLocal8Bit().constData()))
+        {
+            qWarning() << "Cannot listen on" << parser.value(serveOpt);
+            return 1;
+        }
+        qInfo().noquote() << QString("Serving on %1 with %2 workers").arg(parser.value(serveOpt))
+                             .arg(server.getWorkerCount());
+        server.run();
+        return 0;
+    }
+#endif
+    if (parser.isSet(seedOpt))
+    {
+        gameSeed = parser.value(seedOpt).toUInt(&gameSeedOk);
+        if (!gameSeedOk) gameSeed = 0; // Reset if failed
+    }
+    const Variant_t variant = GetVariant(parser, variantOpt);
+    if (variant == INVALID_VARIANT)
+    {
+        qWarning() << "Unknown variant" << parser.value(variantOpt);
+        return 1;
+    }
+    const DealVersion_t dealVersion = GetDealVersion(parser, dealOpt);
+    if (dealVersion == INVALID_DEAL_VERSION)
+    {
+        qWarning() << "Unknown deal version" << parser.value(dealOpt);
+        return 1;
+    }
+    const bool render = !parser.isSet(noRenderOpt);
+    if (parser.isSet(scriptOpt))
+    {
+        inFile = fopen(parser.value(scriptOpt).toLocal8Bit().constData(), "r");
+        if (inFile == nullptr)
+        {
+            qWarning() << "Cannot open script" << parser.value(scriptOpt);
+            return 1;
+        }
+    }
+
+    GameConsole console(stdout, GetRenderMode(parser, renderOpt), inFile);
+    if (render) qDebug() << "... Variant:" << GetVariantName(variant);
+
+    switch (variant)
+    {
+    case FREECELL:
+        status = gameLoop<FreeCellRules>(gameSeed, dealVersion, console, render, nullptr);
+        break;
+    case SPIDER_1_SUIT:
+        status = gameLoop<Spider1Rules>(gameSeed, dealVersion, console, render, nullptr);
+        break;
+    case SPIDER_2_SUIT:
+        status = gameLoop<Spider2Rules>(gameSeed, dealVersion, console, render, nullptr);
+        break;
+    case SPIDER_4_SUIT:
+        status = gameLoop<Spider4Rules>(gameSeed, dealVersion, console, render, nullptr);
+        break;
+    default:
+        status = gameLoop<KlondikeRules>(gameSeed, dealVersion, console, render, &hintEngine);
+        break;
+    }
+    if (inFile != stdin) fclose(inFile);
+
+    return status;
+}
@@ -0,0 +1,9 @@
+#ifndef SOLITAIRE_H
+#define SOLITAIRE_H
+
+#include "variant.h"
+
+
+int Solitaire(int argc, char *argv[]);
+
+#endif // SOLITAIRE_H
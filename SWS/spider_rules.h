@@ -0,0 +1,310 @@
+#ifndef SPIDER_RULES_H
+#define SPIDER_RULES_H
+
+#include "game.h"
+
+
+#define SPIDER_CARD_COUNT        (2 * CARDS_PER_STD_DECK)
+#define SPIDER_FOUNDATION_COUNT  (SPIDER_CARD_COUNT / CARDS_PER_STD_SUIT)
+#define SPIDER_TABLEAU_COUNT     (10)
+#define SPIDER_DEAL_COUNT        (54)  // Opening deal; the rest stays in the stock
+
+#define SPIDER_ADD_MOVE(st, si, dt, di, n)  \
+    do { GameMove_t &m = pMoves[moveCnt++]; m.srcType = (st); m.srcId = (si); m.dstType = (dt); m.dstId = (di); m.count = (n); } while (0)
+
+
+// Spider rules for 'RulesGame' and 'RulesSolver', over 'Suits' suits copied
+//   up to 104 cards; cards build down in any suit, but only same-suit runs
+//   move together and only a full king-to-ace run goes home
+/* Dealing a card to every tableau pile is the 'deal' command, allowed while no
+ * pile is empty; as a generated move it is 'DECK' to 'TABLEAU' with a count of
+ * 'SPIDER_TABLEAU_COUNT'. Turning up a face-down top is the 'flip' command; as
+ * a generated move it is a tableau pile to itself, so a solution replays
+ * command by command. */
+template <DeckType_t Suits>
+class SpiderRules
+{
+    static_assert(SPIDER_CARD_COUNT % (Suits * CARDS_PER_STD_SUIT) == 0, "Spider suits must divide the 104 cards");
+
+public:
+    static const DeckType_t deckType = Suits;
+    static const int deckCount = SPIDER_CARD_COUNT / (Suits * CARDS_PER_STD_SUIT);
+    static constexpr PileLayout_t layout[] = {
+        {DECK,       1,                       0, 0},
+        {FOUNDATION, SPIDER_FOUNDATION_COUNT, 2, 0},
+        {TABLEAU,    SPIDER_TABLEAU_COUNT,    0, 1}
+    };
+    static const PileType_t dealPileType = TABLEAU;
+    static const DealMethod_t dealMethod = ALL;
+    static const int dealCount = SPIDER_DEAL_COUNT;
+
+    static inline void checkForWin(PileMap_t &pileMap, GameState_t &state);
+    static inline CmdError_t validateCommand(PileMap_t &pileMap, Cdb_t &cdb);
+    static inline GameError_t dealStock(Game &game);
+
+    static inline int genMoves(PileMap_t &pileMap, GameMove_t *pMoves);
+    static inline void playMove(Game &game, const GameMove_t &move);
+
+private:
+    static inline int runLength(Pile *pPile);
+    static inline bool canDeal(PileMap_t &pileMap);
+    static inline int firstEmptyFoundation(PileMap_t &pileMap);
+};
+
+template <DeckType_t Suits>
+constexpr PileLayout_t SpiderRules<Suits>::layout[];
+
+typedef SpiderRules<ONE_SUIT_DECK> Spider1Rules;
+typedef SpiderRules<TWO_SUIT_DECK> Spider2Rules;
+typedef SpiderRules<STD_DECK> Spider4Rules;
+
+
+// Length of face-up same-suit descending run on top of pile
+template <DeckType_t Suits>
+inline int SpiderRules<Suits>::runLength(Pile *pPile)
+{
+    int cnt = pPile->getCardCount();
+    int len;
+
+    if (cnt == 0 || !pPile->getCardAt(cnt - 1).isFaceUp()) return 0;
+    for (len = 1; len < cnt; len++)
+    {
+        Card upper = pPile->getCardAt(cnt - len);
+        Card lower = pPile->getCardAt(cnt - len - 1);
+        if (!lower.isFaceUp() || lower.getSuit() != upper.getSuit() || lower.getValue() != upper.getValue() + 1) break;
+    }
+
+    return len;
+}
+
+// Stock may be dealt: cards left and no empty tableau pile
+template <DeckType_t Suits>
+inline bool SpiderRules<Suits>::canDeal(PileMap_t &pileMap)
+{
+    if (PILE_DECK->getCardCount() < SPIDER_TABLEAU_COUNT) return false;
+    for (auto pPile : PILE_VECTOR(TABLEAU))
+    {
+        if (pPile->getCardCount() == 0) return false;
+    }
+
+    return true;
+}
+
+// First empty foundation, or -1
+template <DeckType_t Suits>
+inline int SpiderRules<Suits>::firstEmptyFoundation(PileMap_t &pileMap)
+{
+    for (auto f = 0; f < SPIDER_FOUNDATION_COUNT; f++)
+    {
+        if (PILE(FOUNDATION, f)->getCardCount() == 0) return f;
+    }
+
+    return -1;
+}
+
+// Won when nothing is left off the foundations
+template <DeckType_t Suits>
+inline void SpiderRules<Suits>::checkForWin(PileMap_t &pileMap, GameState_t &state)
+{
+    for (auto pPile : PILE_MAP)
+    {
+        if (pPile->getType() != FOUNDATION && pPile->getCardCount() != 0) return;
+    }
+    state = GAME_WON;
+}
+
+// Validate command against table; sets card count of a move, which must match
+//   any count given in the command
+template <DeckType_t Suits>
+inline CmdError_t SpiderRules<Suits>::validateCommand(PileMap_t &pileMap, Cdb_t &cdb)
+{
+    Pile *pSrcPile;
+    Pile *pDstPile;
+    int given = cdb.count;
+    int run;
+
+    cdb.count = 0;
+    switch (cdb.cmdId)
+    {
+    case _CLEAR_CMD:
+    case _KEY_CMD:
+    case _QUIT_CMD:
+    case _UNDO_CMD:
+    case _REDO_CMD:
+    case _HINT_CMD:
+        return CS_OK;
+
+    case _DEAL_CMD:
+        if (!canDeal(pileMap)) return CS_BAD_MOVE;
+        cdb.count = SPIDER_TABLEAU_COUNT;
+        return CS_OK;
+
+    case _FLIP_CMD:
+        // Only a face-down tableau top may be turned up
+        if (!IS_VALID_PILE_TYPE(cdb.src.pileType)) return CS_MISSING_ARGS;
+        if (!PILE_MAP.contains(cdb.src.pileType, cdb.src.id)) return CS_BAD_ARG_1;
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        if (cdb.src.pileType != TABLEAU || pSrcPile->getCardCount() == 0 || pSrcPile->topCard().isFaceUp())
+        {
+            return CS_BAD_MOVE;
+        }
+        cdb.count = 1;
+        return CS_OK;
+
+    case _MOVE_CMD:
+    case _FORCE_CMD:
+        if (!IS_VALID_PILE_TYPE(cdb.src.pileType) || !IS_VALID_PILE_TYPE(cdb.dst.pileType)) return CS_MISSING_ARGS;
+        if (!PILE_MAP.contains(cdb.src.pileType, cdb.src.id)) return CS_BAD_ARG_1;
+        if (!PILE_MAP.contains(cdb.dst.pileType, cdb.dst.id)) return CS_BAD_ARG_2;
+        pSrcPile = PILE(cdb.src.pileType, cdb.src.id);
+        pDstPile = PILE(cdb.dst.pileType, cdb.dst.id);
+        if (pSrcPile == pDstPile || pSrcPile->getCardCount() == 0) return CS_BAD_MOVE;
+
+        // Forced move skips the rules; top card only
+        if (cdb.cmdId == _FORCE_CMD)
+        {
+            cdb.count = 1;
+            return (given <= 1)? CS_OK : CS_BAD_MOVE;
+        }
+        if (cdb.src.pileType != TABLEAU) return CS_BAD_MOVE;
+        run = runLength(pSrcPile);
+
+        switch (cdb.dst.pileType)
+        {
+        case FOUNDATION:
+            // Complete king-to-ace run only
+            if (run < CARDS_PER_STD_SUIT || pDstPile->getCardCount() != 0) return CS_BAD_MOVE;
+            if (given != 0 && given != CARDS_PER_STD_SUIT) return CS_BAD_MOVE;
+            cdb.count = CARDS_PER_STD_SUIT;
+            return CS_OK;
+
+        case TABLEAU:
+            // Any part of the run to an empty pile, the whole run unless a count
+            //   is given; else the part that fits
+            if (pDstPile->getCardCount() == 0) cdb.count = (given != 0)? given : run;
+            else if (pDstPile->topCard().isFaceUp())
+            {
+                cdb.count = pDstPile->topCard().getValue() - pSrcPile->topCard().getValue();
+            }
+            if (cdb.count < 1 || cdb.count > run || (given != 0 && cdb.count != given)) cdb.count = 0;
+            return (cdb.count != 0)? CS_OK : CS_BAD_MOVE;
+
+        default:
+            return CS_BAD_MOVE;
+        }
+
+    default:
+        return CS_BAD_CMD;
+    }
+}
+
+// Deal one card face up from the stock to each tableau pile; used by the 'deal'
+//   command and the solver alike
+template <DeckType_t Suits>
+inline GameError_t SpiderRules<Suits>::dealStock(Game &game)
+{
+    PileMap_t &pileMap = game.getPileMap();
+    GameError_t status;
+
+    for (auto pPile : PILE_VECTOR(TABLEAU))
+    {
+        status = game.moveCard(PILE_DECK, pPile);
+        if (status == GS_OK) status = game.flipTopCard(pPile);
+        if (status != GS_OK) return status;
+    }
+
+    return GS_OK;
+}
+
+// Generate candidate moves in search order; a face-down top to turn, else a
+//   complete run home, if any, is returned alone
+/* Tableau moves come in three passes: onto a same-suit card (the run grows),
+ * moves that turn a card or empty a pile, then the rest. A run already
+ * sitting on a card one rank up only moves to join a same-suit card, and
+ * only the whole run of a pile with cards beneath goes to the first empty
+ * pile. */
+template <DeckType_t Suits>
+inline int SpiderRules<Suits>::genMoves(PileMap_t &pileMap, GameMove_t *pMoves)
+{
+    int moveCnt = 0;
+    int run[SPIDER_TABLEAU_COUNT];
+    int firstEmpty = -1;
+    int f;
+
+    for (auto t = 0; t < SPIDER_TABLEAU_COUNT; t++)
+    {
+        Pile *pPile = PILE(TABLEAU, t);
+        if (pPile->getCardCount() != 0 && !pPile->topCard().isFaceUp())
+        {
+            SPIDER_ADD_MOVE(TABLEAU, t, TABLEAU, t, 1);
+            return moveCnt;
+        }
+    }
+
+    for (auto t = 0; t < SPIDER_TABLEAU_COUNT; t++)
+    {
+        Pile *pPile = PILE(TABLEAU, t);
+        run[t] = runLength(pPile);
+        if (pPile->getCardCount() == 0 && firstEmpty < 0) firstEmpty = t;
+        if (run[t] == CARDS_PER_STD_SUIT && (f = firstEmptyFoundation(pileMap)) >= 0)
+        {
+            moveCnt = 0;
+            SPIDER_ADD_MOVE(TABLEAU, t, FOUNDATION, f, CARDS_PER_STD_SUIT);
+            return moveCnt;
+        }
+    }
+
+    for (auto pass = 0; pass < 3; pass++)
+    {
+        for (auto s = 0; s < SPIDER_TABLEAU_COUNT; s++)
+        {
+            Pile *pSrcPile = PILE(TABLEAU, s);
+            int cnt = pSrcPile->getCardCount();
+            if (run[s] == 0) continue;
+
+            Card srcTop = pSrcPile->topCard();
+            for (auto d = 0; d < SPIDER_TABLEAU_COUNT; d++)
+            {
+                Pile *pDstPile = PILE(TABLEAU, d);
+                if (d == s || pDstPile->getCardCount() == 0) continue;
+
+                Card dstTop = pDstPile->topCard();
+                int n = dstTop.getValue() - srcTop.getValue();
+                if (n < 1 || n > run[s]) continue;
+
+                // Card left behind; whether the move joins suits or frees something
+                Card under = pSrcPile->getCardAt(cnt - n - 1);
+                bool sameSuit = (dstTop.getSuit() == srcTop.getSuit());
+                bool frees = under.isNull() || !under.isFaceUp();
+                bool seated = !frees && under.getValue() == srcTop.getValue() + n;
+                if (seated && (!sameSuit || under.getSuit() == srcTop.getSuit())) continue;
+
+                int movePass = sameSuit? 0 : (frees? 1 : 2);
+                if (movePass == pass) SPIDER_ADD_MOVE(TABLEAU, s, TABLEAU, d, n);
+            }
+
+            // Whole run to the first empty pile
+            if (pass == 1 && firstEmpty >= 0 && run[s] < cnt) SPIDER_ADD_MOVE(TABLEAU, s, TABLEAU, firstEmpty, run[s]);
+        }
+    }
+
+    // Deal from the stock last
+    if (canDeal(pileMap)) SPIDER_ADD_MOVE(DECK, 0, TABLEAU, 0, SPIDER_TABLEAU_COUNT);
+
+    return moveCnt;
+}
+
+// Play generated move; a card left face down on top waits for its flip move
+template <DeckType_t Suits>
+inline void SpiderRules<Suits>::playMove(Game &game, const GameMove_t &move)
+{
+    PileMap_t &pileMap = game.getPileMap();
+    Pile *pSrcPile = PILE((PileType_t)move.srcType, move.srcId);
+    Pile *pDstPile = PILE((PileType_t)move.dstType, move.dstId);
+
+    if (move.srcType == DECK) dealStock(game);
+    else if (pSrcPile == pDstPile) game.flipTopCard(pSrcPile);
+    else game.moveCards(pSrcPile, pDstPile, move.count);
+}
+
+#endif // SPIDER_RULES_H
@@ -0,0 +1,47 @@
+#include "transposition_table.h"
+
+using namespace std;
+
+
+////////////////////////////////
+// TranspositionTable class methods
+
+TranspositionTable::TranspositionTable(size_t memoryCap) : memoryCap(memoryCap)
+{
+    table.fill(0, 1 << TT_INITIAL_BITS);
+    mask = table.size() - 1;
+    used = 0;
+}
+
+// Forget all keys; a table grown by a large search drops back to its
+//   initial size
+void TranspositionTable::clear()
+{
+    if (table.size() > (1 << TT_INITIAL_BITS)) table = QVector<quint64>(1 << TT_INITIAL_BITS, 0);
+    else table.fill(0);
+    mask = table.size() - 1;
+    used = 0;
+}
+
+// Double table size and rehash; returns 'false' if that would exceed the cap
+bool TranspositionTable::grow()
+{
+    QVector<quint64> oldTable;
+    size_t newSize = (size_t)table.size() * 2;
+
+    if (newSize * sizeof(quint64) > memoryCap) return false;
+
+    oldTable.swap(table);
+    table = QVector<quint64>((int)newSize, 0);
+    mask = newSize - 1;
+
+    for (auto key : oldTable)
+    {
+        if (key == 0) continue;
+        quint64 i;
+        for (i = key & mask; table[i] != 0; i = (i + 1) & mask);
+        table[i] = key;
+    }
+
+    return true;
+}
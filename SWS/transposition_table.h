@@ -0,0 +1,70 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <QVector>
+
+
+#define TT_DEFAULT_MEMORY_CAP  (64u << 20)  // Bytes
+#define TT_INITIAL_BITS        (16)         // log2 of initial entry count
+
+
+// Insert results
+typedef enum
+{
+    TT_NEW,      // Key was not present and has been added
+    TT_PRESENT,  // Key was already present
+    TT_FULL      // Key not present; table is at its memory cap
+} TTStatus_t;
+
+
+// Open-addressed set of 64-bit position hashes; grows from a small size up to
+//   its memory cap so short searches stay cheap to clear
+class TranspositionTable
+{
+public:
+    TranspositionTable(size_t memoryCap = TT_DEFAULT_MEMORY_CAP);
+
+    void clear();
+    inline TTStatus_t insert(quint64 key);
+
+    inline void setMemoryCap(size_t cap)  { memoryCap = cap; }
+    inline size_t getMemoryUsage() const  { return (size_t)table.size() * sizeof(quint64); }
+    inline quint64 getEntryCount() const  { return used; }
+
+private:
+    bool grow();
+
+    QVector<quint64> table;
+    quint64 mask;
+    quint64 used;
+    size_t memoryCap;
+};
+
+// Add key to set; keys are expected to be well mixed already
+inline TTStatus_t TranspositionTable::insert(quint64 key)
+{
+    quint64 *pTable = table.data();
+    quint64 i;
+
+    if (key == 0) key = 1;  // Zero marks an empty slot
+
+    for (i = key & mask; pTable[i] != 0; i = (i + 1) & mask)
+    {
+        if (pTable[i] == key) return TT_PRESENT;
+    }
+
+    // Keep load under 3/4
+    if ((used + 1) * 4 > (mask + 1) * 3)
+    {
+        if (!grow()) return TT_FULL;
+        pTable = table.data();
+        for (i = key & mask; pTable[i] != 0; i = (i + 1) & mask);
+    }
+
+    pTable[i] = key;
+    used++;
+
+    return TT_NEW;
+}
+
+#endif // TRANSPOSITION_TABLE_H
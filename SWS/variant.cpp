@@ -0,0 +1,47 @@
+#include <QCoreApplication>
+#include <QByteArray>
+#include "variant.h"
+
+
+// Variant names, as given to '--variant'
+static const char *variantName[] = {"klondike", "freecell", "spider1", "spider2", "spider4"};
+
+
+////////////////////////
+// Standard functions
+
+// Name of variant
+const char * GetVariantName(Variant_t variant)
+{
+    if (variant < KLONDIKE || variant >= INVALID_VARIANT) return "unknown";
+
+    return variantName[variant];
+}
+
+// Add game variant option
+const QCommandLineOption & AddVariantOption(QCommandLineParser &parser)
+{
+    static const QCommandLineOption variantOpt(QStringList() << "variant",
+        QCoreApplication::translate("main", "Set game variant: klondike, freecell, spider1, spider2 or spider4."),
+        QCoreApplication::translate("main", "name"), variantName[KLONDIKE]);
+    parser.addOption(variantOpt);
+
+    return variantOpt;
+}
+
+// Variant by name, ignoring case; 'INVALID_VARIANT' if the name is not known
+Variant_t FindVariant(const char *pName)
+{
+    for (auto v = 0; v < INVALID_VARIANT; v++)
+    {
+        if (qstricmp(pName, variantName[v]) == 0) return (Variant_t)v;
+    }
+
+    return INVALID_VARIANT;
+}
+
+// Game variant selected; 'INVALID_VARIANT' if the name is not known
+Variant_t GetVariant(const QCommandLineParser &parser, const QCommandLineOption &variantOpt)
+{
+    return FindVariant(parser.value(variantOpt).toLatin1().constData());
+}
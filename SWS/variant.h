@@ -0,0 +1,24 @@
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#include <QCommandLineParser>
+
+
+// Game variants
+typedef enum
+{
+    KLONDIKE,
+    FREECELL,
+    SPIDER_1_SUIT,
+    SPIDER_2_SUIT,
+    SPIDER_4_SUIT,
+    INVALID_VARIANT
+} Variant_t;
+
+
+const char * GetVariantName(Variant_t variant);
+Variant_t FindVariant(const char *pName);
+const QCommandLineOption & AddVariantOption(QCommandLineParser &parser);
+Variant_t GetVariant(const QCommandLineParser &parser, const QCommandLineOption &variantOpt);
+
+#endif // VARIANT_H
@@ -0,0 +1,64 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET = tst_sws_bench
+CONFIG   += console
+CONFIG   -= app_bundle
+CONFIG   += thread
+
+# Benchmarks are only meaningful with optimisation on
+CONFIG   += release
+
+TEMPLATE = app
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which as been marked as deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+
+SOURCES += tst_sws_bench.cpp \
+    ../SWS/card.cpp \
+    ../SWS/command.cpp \
+    ../SWS/console.cpp \
+    ../SWS/game.cpp \
+    ../SWS/game_arena.cpp \
+    ../SWS/klondike.cpp \
+    ../SWS/klondike_state.cpp \
+    ../SWS/klondike_solver.cpp \
+    ../SWS/klondike_hint.cpp \
+    ../SWS/freecell_rules.cpp \
+    ../SWS/variant.cpp \
+    ../SWS/transposition_table.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+HEADERS += \
+    ../SWS/card.h \
+    ../SWS/card_stack.h \
+    ../SWS/command.h \
+    ../SWS/console.h \
+    ../SWS/game.h \
+    ../SWS/game_arena.h \
+    ../SWS/klondike.h \
+    ../SWS/klondike_state.h \
+    ../SWS/klondike_rules.h \
+    ../SWS/klondike_solver.h \
+    ../SWS/klondike_hint.h \
+    ../SWS/freecell_rules.h \
+    ../SWS/spider_rules.h \
+    ../SWS/rules_solver.h \
+    ../SWS/variant.h \
+    ../SWS/transposition_table.h
+
+# Game server uses POSIX sockets
+unix {
+    SOURCES += ../SWS/server.cpp
+    HEADERS += ../SWS/server.h
+}
@@ -0,0 +1,556 @@
+#include <QString>
+#include <QtTest>
+#include <algorithm>
+#include <chrono>
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define private public
+#include "../SWS/game.h"
+#include "../SWS/klondike.h"
+#include "../SWS/klondike_rules.h"
+#include "../SWS/klondike_state.h"
+#ifdef Q_OS_UNIX
+#include "../SWS/server.h"
+#endif
+
+
+#ifdef Q_OS_WIN
+#define NULL_DEVICE  "NUL"
+#else
+#define NULL_DEVICE  "/dev/null"
+#endif
+
+#define BENCH_SERVER_SESSIONS  (256)  // Sessions a server burst is spread over
+
+
+void stub_checkForWin(PileMap_t &, GameState_t &);
+CmdError_t stub_processCmd(PileMap_t &, Cdb_t &);
+
+
+// Benchmark class for SWS engine hot paths; run with e.g. '-o results.csv,csv'
+//   or '-o results.xml,xml' for machine-readable output
+class SWS_Bench : public QObject
+{
+    Q_OBJECT
+
+public:
+    SWS_Bench();
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // Deck benchmarks
+    void benchShuffle_data();
+    void benchShuffle();
+
+    // Game benchmarks
+    void benchDeal_data();
+    void benchDeal();
+    void benchReset_data();
+    void benchReset();
+    void benchMoveCards_data();
+    void benchMoveCards();
+    void benchCheckForWin_data();
+    void benchCheckForWin();
+    void benchProcessCommand_data();
+    void benchProcessCommand();
+
+    // Console benchmarks
+    void benchPrintTable_data();
+    void benchPrintTable();
+    void benchTokenize_data();
+    void benchTokenize();
+
+    // Klondike benchmarks
+    void benchLegalMoves_data();
+    void benchLegalMoves();
+    void benchDeadEnd_data();
+    void benchDeadEnd();
+
+#ifdef Q_OS_UNIX
+    // Server benchmarks
+    void benchServerBurst_data();
+    void benchServerBurst();
+#endif
+
+private:
+    FILE *nullOut;
+};
+
+
+// Deck type name for row tags
+static const char * deckName(DeckType_t deckType)
+{
+    static const char * deckTable[] = {"", "1suit", "2suit", "3suit", "std"};
+
+    return deckTable[deckType];
+}
+
+// Add one row per deck type
+static void addDeckRows()
+{
+    QTest::addColumn<int>("deckType");
+
+    for (auto d = (int)ONE_SUIT_DECK; d <= (int)STD_DECK; d++)
+    {
+        QTest::newRow(deckName((DeckType_t)d)) << d;
+    }
+}
+
+// Add one row per deck type and board fill level
+static void addTableRows()
+{
+    static const int fillTable[] = {0, 50, 100};
+
+    QTest::addColumn<int>("deckType");
+    QTest::addColumn<int>("fillPct");
+
+    for (auto d = (int)ONE_SUIT_DECK; d <= (int)STD_DECK; d++)
+    {
+        for (auto fill : fillTable)
+        {
+            QString tag = QString("%1/%2%").arg(deckName((DeckType_t)d)).arg(fill);
+            QTest::newRow(tag.toLatin1().constData()) << d << fill;
+        }
+    }
+}
+
+// Register Klondike piles and deal 'fillPct' percent of the deck face up,
+//   round-robin over foundations and tableau
+static void fillTable(Game &game, int fillPct)
+{
+    PileMap_t &pileMap = game.getPileMap();
+    int dealCnt;
+    int p = 0;
+
+    game.registerPile(DECK, 1, 0, 0);
+    game.registerPile(DISCARD, 1, 1, 0);
+    game.registerPile(FOUNDATION, KLONDIKE_FOUNDATION_COUNT, 3, 0);
+    game.registerPile(TABLEAU, KLONDIKE_TABLEAU_COUNT, 0, 1);
+
+    dealCnt = PILE_DECK->getCardCount() * fillPct / 100;
+    for (auto i = 0; i < dealCnt; i++)
+    {
+        Pile *pPile = (p < KLONDIKE_FOUNDATION_COUNT)? PILE(FOUNDATION, p) : PILE(TABLEAU, p - KLONDIKE_FOUNDATION_COUNT);
+        game.moveCard(PILE_DECK, pPile);
+        game.flipTopCard(pPile);
+        p = (p + 1) % (KLONDIKE_FOUNDATION_COUNT + KLONDIKE_TABLEAU_COUNT);
+    }
+    game.clearJournal();
+}
+
+// Add one row per playout depth
+static void addPlyRows()
+{
+    static const int plyTable[] = {0, 25, 50, 100};
+
+    QTest::addColumn<int>("ply");
+
+    for (auto ply : plyTable)
+    {
+        QTest::newRow(QString("ply%1").arg(ply).toLatin1().constData()) << ply;
+    }
+}
+
+#ifdef Q_OS_UNIX
+// Connect to server socket and open 'BENCH_SERVER_SESSIONS' Klondike sessions;
+//   '-1' on failure
+static int openServerSessions(const char *pPath)
+{
+    sockaddr_un addr;
+    char buf[64];
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, pPath, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || ::connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) return -1;
+
+    for (auto s = 0; s < BENCH_SERVER_SESSIONS; s++)
+    {
+        int len = snprintf(buf, sizeof(buf), "open klondike %d\n", s + 1);
+        if (send(fd, buf, len, 0) != len) return -1;
+        do { if (recv(fd, buf, 1, 0) != 1) return -1; } while (buf[0] != '\n');
+    }
+
+    return fd;
+}
+#endif
+
+// Klondike position after a fixed playout of 'ply' legal moves from the deal
+static void playOut(KlondikeState_t &st, int ply)
+{
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 1);
+    KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+
+    KlondikeSetUp(klondike);
+    KlondikeStateFromGame(st, klondike);
+    for (auto i = 0; i < ply; i++)
+    {
+        int moveCnt = KlondikeStateLegalMoves(st, moves);
+        KlondikeStateApply(st, moves[(i * 7) % moveCnt]);
+    }
+}
+
+
+////////////////////////////
+// SWS_Bench class methods
+
+SWS_Bench::SWS_Bench()
+{
+    nullOut = nullptr;
+}
+
+void SWS_Bench::initTestCase()
+{
+    nullOut = fopen(NULL_DEVICE, "w");
+    QVERIFY(nullOut != nullptr);
+}
+
+void SWS_Bench::cleanupTestCase()
+{
+    if (nullOut != nullptr) fclose(nullOut);
+}
+
+// Shuffle per deck type and deal generator version
+void SWS_Bench::benchShuffle_data()
+{
+    QTest::addColumn<int>("deckType");
+    QTest::addColumn<int>("dealVersion");
+
+    for (auto d = (int)ONE_SUIT_DECK; d <= (int)STD_DECK; d++)
+    {
+        for (auto v = 0; v < DEAL_VERSION_COUNT; v++)
+        {
+            QString tag = QString("%1/v%2").arg(deckName((DeckType_t)d)).arg(v);
+            QTest::newRow(tag.toLatin1().constData()) << d << v;
+        }
+    }
+}
+
+void SWS_Bench::benchShuffle()
+{
+    QFETCH(int, deckType);
+    QFETCH(int, dealVersion);
+    Deck deck((DeckType_t)deckType);
+    unsigned seed = 1;
+
+    QBENCHMARK
+    {
+        deck.shuffle(seed++, (DealVersion_t)dealVersion);
+    }
+}
+
+// Opening deal; a deal empties the stock, so each pass builds a fresh table
+void SWS_Bench::benchDeal_data()
+{
+    addDeckRows();
+}
+
+void SWS_Bench::benchDeal()
+{
+    QFETCH(int, deckType);
+    unsigned seed = 1;
+
+    QBENCHMARK
+    {
+        Game game((DeckType_t)deckType, stub_checkForWin, stub_processCmd, seed++);
+        KlondikeSetUp(game);
+    }
+}
+
+// Opening deal of one game re-dealt in place; compare with 'benchDeal'
+void SWS_Bench::benchReset_data()
+{
+    addDeckRows();
+}
+
+void SWS_Bench::benchReset()
+{
+    QFETCH(int, deckType);
+    Game game((DeckType_t)deckType, stub_checkForWin, stub_processCmd, 1);
+    unsigned seed = 2;
+
+    KlondikeSetUp(game);
+
+    QBENCHMARK
+    {
+        game.reset(seed++);
+    }
+}
+
+// Single card moved out and back; journal cleared so it does not grow
+void SWS_Bench::benchMoveCards_data()
+{
+    addTableRows();
+}
+
+void SWS_Bench::benchMoveCards()
+{
+    QFETCH(int, deckType);
+    QFETCH(int, fillPct);
+    Game game((DeckType_t)deckType, stub_checkForWin, stub_processCmd, 1);
+    PileMap_t &pileMap = game.getPileMap();
+    Pile *pSrcPile, *pDstPile;
+
+    fillTable(game, fillPct);
+    pSrcPile = (PILE_DECK->getCardCount() != 0)? PILE_DECK : PILE(TABLEAU, 0);
+    pDstPile = PILE(TABLEAU, KLONDIKE_TABLEAU_COUNT - 1);
+    QVERIFY(pSrcPile->getCardCount() != 0);
+
+    QBENCHMARK
+    {
+        game.moveCard(pSrcPile, pDstPile);
+        game.moveCard(pDstPile, pSrcPile);
+        game.clearJournal();
+    }
+}
+
+void SWS_Bench::benchCheckForWin_data()
+{
+    addTableRows();
+}
+
+void SWS_Bench::benchCheckForWin()
+{
+    QFETCH(int, deckType);
+    QFETCH(int, fillPct);
+    Game game((DeckType_t)deckType, stub_checkForWin, stub_processCmd, 1);
+    GameState_t state = GAME_IN_PROGRESS;
+
+    fillTable(game, fillPct);
+
+    QBENCHMARK
+    {
+        klondikeCheckForWin(game.getPileMap(), state);
+    }
+}
+
+// Draw and undo as commands, with rules called through pointers or bound at
+//   compile time
+void SWS_Bench::benchProcessCommand_data()
+{
+    QTest::addColumn<bool>("rulesBound");
+
+    QTest::newRow("pointers") << false;
+    QTest::newRow("rules") << true;
+}
+
+void SWS_Bench::benchProcessCommand()
+{
+    QFETCH(bool, rulesBound);
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 1);
+    RulesGame<KlondikeRules> rulesGame(1);
+    GameConsole console(nullOut);
+    Cdb_t drawCdb;
+    Cdb_t undoCdb;
+
+    KlondikeSetUp(klondike);
+    rulesGame.setUp();
+    console.tokenize(drawCdb, "move d0 s0", 10);
+    console.tokenize(undoCdb, "undo", 4);
+
+    if (rulesBound)
+    {
+        QBENCHMARK
+        {
+            rulesGame.processCommand(drawCdb);
+            rulesGame.processCommand(undoCdb);
+        }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            klondike.processCommand(drawCdb);
+            klondike.processCommand(undoCdb);
+        }
+    }
+    QVERIFY(klondike.getJournalSize() <= 1 && rulesGame.getJournalSize() <= 1);
+}
+
+// Table render of an unchanged table, through Game::print so the console's
+//   cached layout is used; output discarded
+void SWS_Bench::benchPrintTable_data()
+{
+    addTableRows();
+}
+
+void SWS_Bench::benchPrintTable()
+{
+    QFETCH(int, deckType);
+    QFETCH(int, fillPct);
+    Game game((DeckType_t)deckType, stub_checkForWin, stub_processCmd, 1);
+    GameConsole console(nullOut);
+
+    fillTable(game, fillPct);
+
+    QBENCHMARK
+    {
+        game.print(console);
+    }
+}
+
+// Command tokenizing from raw line bytes
+void SWS_Bench::benchTokenize_data()
+{
+    QTest::addColumn<QString>("cmdStr");
+
+    QTest::newRow("move") << "move t1 f3";
+    QTest::newRow("flip") << "flip d";
+    QTest::newRow("undo") << "undo";
+    QTest::newRow("bad_cmd") << "floop f2";
+    QTest::newRow("bad_arg") << "move t1 x9";
+    QTest::newRow("excess") << "undo f0 t1 c3";
+}
+
+void SWS_Bench::benchTokenize()
+{
+    QFETCH(QString, cmdStr);
+    GameConsole console(nullOut);
+    QByteArray line = cmdStr.toLatin1();
+    Cdb_t cdb;
+
+    QBENCHMARK
+    {
+        console.tokenize(cdb, line.constData(), line.size());
+    }
+}
+
+// Legal move generation along a playout
+void SWS_Bench::benchLegalMoves_data()
+{
+    addPlyRows();
+}
+
+void SWS_Bench::benchLegalMoves()
+{
+    QFETCH(int, ply);
+    KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+    KlondikeState_t st;
+    int moveCnt = 0;
+
+    playOut(st, ply);
+
+    QBENCHMARK
+    {
+        moveCnt = KlondikeStateLegalMoves(st, moves);
+    }
+    QVERIFY(moveCnt > 0);
+}
+
+// Dead-end detection along a playout
+void SWS_Bench::benchDeadEnd_data()
+{
+    addPlyRows();
+}
+
+void SWS_Bench::benchDeadEnd()
+{
+    QFETCH(int, ply);
+    KlondikeState_t st;
+    bool dead = false;
+
+    playOut(st, ply);
+
+    QBENCHMARK
+    {
+        dead = KlondikeStateIsDeadEnd(st);
+    }
+    Q_UNUSED(dead);
+}
+
+
+#ifdef Q_OS_UNIX
+// Pipelined burst of draw and undo commands spread over sessions, sent at once;
+//   each command's latency runs from the send to its reply arriving, and the
+//   median and 99th percentile are logged
+void SWS_Bench::benchServerBurst_data()
+{
+    static const int burstTable[] = {1, 64, 1024};
+
+    QTest::addColumn<int>("burst");
+
+    for (auto burst : burstTable)
+    {
+        QTest::newRow(QString("burst%1").arg(burst).toLatin1().constData()) << burst;
+    }
+}
+
+void SWS_Bench::benchServerBurst()
+{
+    QFETCH(int, burst);
+    GameServer server;
+    QByteArray request;
+    QVector<qint64> latency;
+    char path[64];
+    char buf[4096];
+
+    snprintf(path, sizeof(path), "/tmp/sws_bench_%d.sock", (int)getpid());
+    QVERIFY(server.listen(path));
+    std::thread loop(&GameServer::run, &server);
+    int fd = openServerSessions(path);
+    QVERIFY(fd >= 0);
+
+    // Draw then undo on each session in turn
+    for (auto i = 0; i < burst; i++)
+    {
+        int sid = (i / 2) % BENCH_SERVER_SESSIONS;
+        request.append(QString((i & 1)? "%1 undo\n" : "%1 move d0 s0\n").arg(sid).toLatin1());
+    }
+
+    QBENCHMARK
+    {
+        auto start = std::chrono::steady_clock::now();
+        int replies = 0;
+
+        send(fd, request.constData(), request.size(), 0);
+        while (replies < burst)
+        {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            auto usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            for (auto i = 0; i < n; i++)
+            {
+                if (buf[i] != '\n') continue;
+                latency.append(usec);
+                replies++;
+            }
+        }
+    }
+
+    close(fd);
+    server.stop();
+    loop.join();
+
+    std::sort(latency.begin(), latency.end());
+    QVERIFY(!latency.isEmpty());
+    qInfo().noquote() << QString("  %1 commands: p50 %2 us, p99 %3 us").arg(latency.size())
+                         .arg(latency[latency.size() / 2]).arg(latency[latency.size() * 99 / 100]);
+}
+#endif
+
+
+////////////////////////
+// Standard functions
+
+// Check for win stub
+void stub_checkForWin(PileMap_t &, GameState_t &)
+{
+}
+
+// Process command stub
+CmdError_t stub_processCmd(PileMap_t &, Cdb_t &)
+{
+    return CS_ERROR;
+}
+
+
+QTEST_APPLESS_MAIN(SWS_Bench)
+
+#include "tst_sws_bench.moc"
@@ -0,0 +1,47 @@
+QT += core
+QT -= gui
+
+CONFIG += c++11 thread
+
+TARGET = SWS_Sweep
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../SWS
+
+SOURCES += main.cpp \
+    sweep.cpp \
+    ../SWS/game.cpp \
+    ../SWS/game_arena.cpp \
+    ../SWS/card.cpp \
+    ../SWS/klondike.cpp \
+    ../SWS/klondike_state.cpp \
+    ../SWS/klondike_solver.cpp \
+    ../SWS/freecell_rules.cpp \
+    ../SWS/variant.cpp \
+    ../SWS/transposition_table.cpp \
+    ../SWS/command.cpp \
+    ../SWS/console.cpp
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+HEADERS += \
+    sweep.h \
+    ../SWS/game.h \
+    ../SWS/game_arena.h \
+    ../SWS/card.h \
+    ../SWS/card_stack.h \
+    ../SWS/klondike.h \
+    ../SWS/klondike_state.h \
+    ../SWS/klondike_rules.h \
+    ../SWS/klondike_solver.h \
+    ../SWS/freecell_rules.h \
+    ../SWS/spider_rules.h \
+    ../SWS/rules_solver.h \
+    ../SWS/variant.h \
+    ../SWS/transposition_table.h \
+    ../SWS/command.h \
+    ../SWS/console.h \
+    ../SWS/game_common.h
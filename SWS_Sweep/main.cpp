@@ -0,0 +1,6 @@
+#include "sweep.h"
+
+int main(int argc, char *argv[])
+{
+    return SeedSweep(argc, argv);
+}
@@ -0,0 +1,232 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDebug>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sweep.h"
+#include "variant.h"
+#include "klondike_solver.h"
+#include "rules_solver.h"
+#include "freecell_rules.h"
+#include "spider_rules.h"
+
+using namespace std;
+
+
+#define SWEEP_DEFAULT_NODE_LIMIT  (2000000)
+#define SWEEP_DEFAULT_MEMORY_MB   (64)
+#define SWEEP_FLUSH_BYTES         (64 * 1024)  // Per-worker output buffer flush point
+
+
+// Shared sweep control
+typedef struct _SweepCtrl_t
+{
+    vector<SeedRange> *pRanges;  // One per worker; sized once, as ranges cannot be copied
+    QFile *pOut;
+    mutex outLock;
+    quint64 nodeLimit;
+    DealVersion_t dealVersion;
+    size_t memoryCap;
+    atomic<quint64> won;
+    atomic<quint64> lost;
+    atomic<quint64> noWin;
+    atomic<quint64> timeout;
+    atomic<quint64> nodes;
+} SweepCtrl_t;
+
+
+// Result name for output records
+static const char * resultStr(SolveStatus_t status)
+{
+    switch (status)
+    {
+    case SS_SOLVED:        return "won";
+    case SS_UNSOLVABLE:    return "lost";
+    case SS_NO_WIN_FOUND:  return "nowin";
+    case SS_NODE_LIMIT:
+    case SS_MEMORY_LIMIT:  return "timeout";
+    default:               return "error";
+    }
+}
+
+// Write worker buffer to output file
+static void flushRecords(SweepCtrl_t &ctrl, QByteArray &buf)
+{
+    lock_guard<mutex> lock(ctrl.outLock);
+
+    ctrl.pOut->write(buf);
+    buf.clear();
+}
+
+// Sweep worker; drains its own range, then steals from the others. 'Solver'
+//   is the variant's solver and 'MoveList' the list its 'solveSeed' fills.
+template <class Solver, class MoveList>
+static void sweepWorker(SweepCtrl_t &ctrl, int id)
+{
+    vector<SeedRange> &ranges = *ctrl.pRanges;
+    int rangeCount = (int)ranges.size();
+    Solver solver(ctrl.memoryCap);
+    MoveList solution;
+    QByteArray buf;
+    quint32 seed;
+    quint32 first, end;
+    char line[96];
+
+    solver.setNodeLimit(ctrl.nodeLimit);
+    buf.reserve(SWEEP_FLUSH_BYTES + sizeof(line));
+
+    for (;;)
+    {
+        while (ranges[id].take(seed))
+        {
+            auto start = chrono::steady_clock::now();
+            SolveStatus_t status = solver.solveSeed(seed, solution, ctrl.dealVersion);
+            auto usec = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+            switch (status)
+            {
+            case SS_SOLVED:       ctrl.won++;     break;
+            case SS_UNSOLVABLE:   ctrl.lost++;    break;
+            case SS_NO_WIN_FOUND: ctrl.noWin++;   break;
+            default:              ctrl.timeout++; break;
+            }
+            ctrl.nodes += solver.getNodeCount();
+
+            snprintf(line, sizeof(line), "%u,%s,%llu,%d,%lld,%d\n", seed, resultStr(status),
+                     (unsigned long long)solver.getNodeCount(), solution.size(), (long long)usec,
+                     solver.getBestHome());
+            buf.append(line);
+            if (buf.size() >= SWEEP_FLUSH_BYTES) flushRecords(ctrl, buf);
+        }
+
+        // Own range empty; steal half of another worker's
+        bool stolen = false;
+        for (auto v = 1; v < rangeCount && !stolen; v++)
+        {
+            stolen = ranges[(id + v) % rangeCount].steal(first, end);
+        }
+        if (!stolen) break;
+        ranges[id].assign(first, end);
+    }
+
+    if (!buf.isEmpty()) flushRecords(ctrl, buf);
+}
+
+
+////////////////////////
+// Standard functions
+
+// Seed sweep entry; solve every seed in range and stream per-seed records
+int SeedSweep(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    SweepCtrl_t ctrl;
+    vector<thread> workers;
+    QFile out;
+    quint32 firstSeed, lastSeed;
+    quint64 seedCount;
+    int threadCount = thread::hardware_concurrency();
+    Variant_t variant;
+    void (*worker)(SweepCtrl_t &ctrl, int id);
+    bool ok = true;
+
+    QCoreApplication::setApplicationName("SWS_Sweep");
+    QCoreApplication::setApplicationVersion("1.0");
+    parser.setApplicationDescription("SWS solitaire seed winnability sweep");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    if (threadCount < 1) threadCount = 1; // Core count unknown
+    const QCommandLineOption firstOpt(QStringList() << "f" << "first", "First seed.", "seed", "1");
+    const QCommandLineOption lastOpt(QStringList() << "l" << "last", "Last seed (inclusive).", "seed", "1000");
+    const QCommandLineOption threadOpt(QStringList() << "j" << "threads", "Worker thread count.", "count",
+                                       QString::number(threadCount));
+    const QCommandLineOption outOpt(QStringList() << "o" << "output", "Output CSV file (default stdout).", "file");
+    const QCommandLineOption nodeOpt(QStringList() << "n" << "nodes", "Solver node limit per seed.", "count",
+                                     QString::number(SWEEP_DEFAULT_NODE_LIMIT));
+    const QCommandLineOption memOpt(QStringList() << "m" << "memory", "Solver memory cap per thread (MiB).", "MiB",
+                                    QString::number(SWEEP_DEFAULT_MEMORY_MB));
+    parser.addOption(firstOpt);
+    parser.addOption(lastOpt);
+    parser.addOption(threadOpt);
+    parser.addOption(outOpt);
+    parser.addOption(nodeOpt);
+    parser.addOption(memOpt);
+    const QCommandLineOption variantOpt = AddVariantOption(parser);
+    const QCommandLineOption dealOpt = AddDealVersionOption(parser);
+    parser.process(app);
+
+    // Validate options
+    firstSeed = parser.value(firstOpt).toUInt(&ok);
+    if (ok) lastSeed = parser.value(lastOpt).toUInt(&ok);
+    if (ok) threadCount = parser.value(threadOpt).toInt(&ok);
+    if (ok) ctrl.nodeLimit = parser.value(nodeOpt).toULongLong(&ok);
+    if (ok) ctrl.memoryCap = (size_t)parser.value(memOpt).toUInt(&ok) << 20;
+    variant = GetVariant(parser, variantOpt);
+    ctrl.dealVersion = GetDealVersion(parser, dealOpt);
+    if (!ok || variant == INVALID_VARIANT || ctrl.dealVersion == INVALID_DEAL_VERSION ||
+        lastSeed < firstSeed || lastSeed == numeric_limits<quint32>::max() || threadCount < 1)
+    {
+        qWarning() << "Invalid sweep options";
+        return 1;
+    }
+    if (firstSeed == INVALID_SEED) firstSeed++; // Seed '0' requests a random deal
+
+    if (parser.isSet(outOpt))
+    {
+        out.setFileName(parser.value(outOpt));
+        ok = out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    else ok = out.open(stdout, QIODevice::WriteOnly);
+    if (!ok)
+    {
+        qWarning() << "Cannot open output";
+        return 1;
+    }
+    out.write("seed,result,nodes,moves,usec,home\n");
+
+    // Split seed range evenly; imbalance is fixed up by stealing
+    seedCount = (quint64)lastSeed - firstSeed + 1;
+    if ((quint64)threadCount > seedCount) threadCount = (int)seedCount;
+    vector<SeedRange> ranges(threadCount);
+    for (auto t = 0; t < threadCount; t++)
+    {
+        ranges[t].assign(firstSeed + (quint32)(seedCount * t / threadCount),
+                         firstSeed + (quint32)(seedCount * (t + 1) / threadCount));
+    }
+
+    ctrl.pRanges = &ranges;
+    ctrl.pOut = &out;
+    ctrl.won = 0;
+    ctrl.lost = 0;
+    ctrl.noWin = 0;
+    ctrl.timeout = 0;
+    ctrl.nodes = 0;
+
+    // Klondike has its own compact solver; the other variants search the game engine
+    switch (variant)
+    {
+    case FREECELL:       worker = sweepWorker<RulesSolver<FreeCellRules>, GameMoveList_t>; break;
+    case SPIDER_1_SUIT:  worker = sweepWorker<RulesSolver<Spider1Rules>, GameMoveList_t>;  break;
+    case SPIDER_2_SUIT:  worker = sweepWorker<RulesSolver<Spider2Rules>, GameMoveList_t>;  break;
+    case SPIDER_4_SUIT:  worker = sweepWorker<RulesSolver<Spider4Rules>, GameMoveList_t>;  break;
+    default:             worker = sweepWorker<KlondikeSolver, KlondikeMoveList_t>;         break;
+    }
+
+    // Run workers
+    auto start = chrono::steady_clock::now();
+    for (auto t = 0; t < threadCount; t++) workers.push_back(thread(worker, ref(ctrl), t));
+    for (auto &worker : workers) worker.join();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    out.close();
+
+    qInfo().noquote() << QString("%1 %2 seeds: %3 won, %4 lost, %5 no win found, %6 timeout; %7 nodes in %8 s (%9 seeds/s)")
+                         .arg(GetVariantName(variant)).arg(seedCount).arg(ctrl.won.load()).arg(ctrl.lost.load())
+                         .arg(ctrl.noWin.load()).arg(ctrl.timeout.load()).arg(ctrl.nodes.load()).arg(secs, 0, 'f', 2).arg(seedCount / secs, 0, 'f', 1);
+
+    return 0;
+}
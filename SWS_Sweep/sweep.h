@@ -0,0 +1,67 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <atomic>
+#include <QtGlobal>
+
+
+// Seed range [next, end) owned by one sweep worker, packed into one atomic
+//   word; the owner takes seeds from the front while idle workers steal the
+//   back half
+class SeedRange
+{
+public:
+    SeedRange() : range(0) {}
+
+    inline void assign(quint32 first, quint32 end)  { range.store(pack(first, end)); }
+    inline bool take(quint32 &seed);
+    inline bool steal(quint32 &first, quint32 &end);
+
+private:
+    static inline quint64 pack(quint32 next, quint32 end)  { return ((quint64)end << 32) | next; }
+
+    std::atomic<quint64> range;
+};
+
+// Take next seed from front of range; returns 'false' if empty
+inline bool SeedRange::take(quint32 &seed)
+{
+    quint64 r = range.load();
+
+    while ((quint32)r < (quint32)(r >> 32))
+    {
+        if (range.compare_exchange_weak(r, pack((quint32)r + 1, (quint32)(r >> 32))))
+        {
+            seed = (quint32)r;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Split off back half of range; returns 'false' if fewer than two seeds left
+inline bool SeedRange::steal(quint32 &first, quint32 &end)
+{
+    quint64 r = range.load();
+
+    for (;;)
+    {
+        quint32 next = (quint32)r;
+        quint32 last = (quint32)(r >> 32);
+        if (next >= last || last - next < 2) return false;
+
+        quint32 mid = next + (last - next) / 2;
+        if (range.compare_exchange_weak(r, pack(next, mid)))
+        {
+            first = mid;
+            end = last;
+            return true;
+        }
+    }
+}
+
+
+int SeedSweep(int argc, char *argv[]);
+
+#endif // SWEEP_H
@@ -11,6 +11,7 @@ QT       -= gui
 TARGET = tst_sws_test
 CONFIG   += console
 CONFIG   -= app_bundle
+CONFIG   += thread
 
 TEMPLATE = app
 
@@ -31,12 +32,36 @@ SOURCES += tst_sws_test.cpp \
     ../SWS/command.cpp \
     ../SWS/console.cpp \
     ../SWS/game.cpp \
-    ../SWS/klondike.cpp
+    ../SWS/game_arena.cpp \
+    ../SWS/klondike.cpp \
+    ../SWS/klondike_state.cpp \
+    ../SWS/klondike_solver.cpp \
+    ../SWS/klondike_hint.cpp \
+    ../SWS/freecell_rules.cpp \
+    ../SWS/variant.cpp \
+    ../SWS/transposition_table.cpp
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
 
 HEADERS += \
     ../SWS/card.h \
+    ../SWS/card_stack.h \
     ../SWS/command.h \
     ../SWS/console.h \
     ../SWS/game.h \
-    ../SWS/klondike.h
+    ../SWS/game_arena.h \
+    ../SWS/klondike.h \
+    ../SWS/klondike_state.h \
+    ../SWS/klondike_rules.h \
+    ../SWS/klondike_solver.h \
+    ../SWS/klondike_hint.h \
+    ../SWS/freecell_rules.h \
+    ../SWS/spider_rules.h \
+    ../SWS/rules_solver.h \
+    ../SWS/variant.h \
+    ../SWS/transposition_table.h
+
+# Game server uses POSIX sockets
+unix {
+    SOURCES += ../SWS/server.cpp
+    HEADERS += ../SWS/server.h
+}
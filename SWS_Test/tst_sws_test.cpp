@@ -1,15 +1,59 @@
 #include <QString>
 #include <QtTest>
+#include <chrono>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 #define private public
 #include "../SWS/game.h"
+#include "../SWS/klondike_state.h"
+#include "../SWS/klondike_rules.h"
+#include "../SWS/klondike_solver.h"
+#include "../SWS/klondike_hint.h"
+#include "../SWS/freecell_rules.h"
+#include "../SWS/spider_rules.h"
+#include "../SWS/rules_solver.h"
+#ifdef Q_OS_UNIX
+#include "../SWS/server.h"
+#endif
 
 
 #define TEST_INPUT(s)  QTextStream(s)
 
 
+// FreeCell whose generator offers first, everywhere, a move that plays nothing
+class IdleFreeCellRules : public FreeCellRules
+{
+public:
+    static inline int genMoves(PileMap_t &pileMap, GameMove_t *pMoves)
+    {
+        memset(&pMoves[0], 0, sizeof(GameMove_t));
+        return FreeCellRules::genMoves(pileMap, pMoves + 1) + 1;
+    }
+    static inline void playMove(Game &game, const GameMove_t &move)
+    {
+        if (move.count != 0) FreeCellRules::playMove(game, move);
+    }
+};
+
+
 void stub_checkForWin(PileMap_t &, GameState_t &);
-CmdError_t stub_processCmd(Cdb_t &);
+CmdError_t stub_processCmd(PileMap_t &, Cdb_t &);
+bool indexMatchesTable(PileMap_t &pileMap);
+void drawThrough(Game &game, int steps);
+template <class G, class M>
+bool replaySolution(G &game, const QVector<M> &solution, Game *pTwin = nullptr);
+QByteArray readOutput(FILE *pFile, long pos);
+void applyAnsi(QVector<QByteArray> &screen, const QByteArray &bytes);
+#ifdef Q_OS_UNIX
+int serverConnect(const char *pPath);
+QByteArray serverRequest(int fd, const char *pLine);
+#endif
 
 
 // Test class for SWS project
@@ -21,16 +65,42 @@ public:
     SWS_Test();
 
 private Q_SLOTS:
+    // Card tests
+    void testCardEncoding();
+    void testPileStorage();
+    void testDealGenerator();
+
     // Game control tests
     void testBasicGameInit();
     void testPileRegistration();
     void testCardXfer();
+    void testGameHash();
+    void testUndoRedo();
+    void testGameReset();
+    void testCardIndex();
+    void testWinTracking();
+    void testKlondikeState();
+    void testKlondikeLegalMoves();
+    void testKlondikeDeadEnd();
+    void testKlondikeSolver();
+    void testKlondikeHint();
+    void testVariantDeals();
+    void testRulesSolver();
 
     // Console tests
     void testConsoleInputParsing();
+    void testConsoleDiffRender();
+    void testConsoleLayout();
 
     // Command processing tests
     void testCommandProcessing();
+    void testRulesGame();
+    void testVariantCommands();
+
+#ifdef Q_OS_UNIX
+    // Server tests
+    void testGameServer();
+#endif
 };
 
 
@@ -41,13 +111,91 @@ SWS_Test::SWS_Test()
 {
 }
 
+// Test packed card encoding
+void SWS_Test::testCardEncoding()
+{
+    Card card(CLUBS, QUEEN);
+
+    // Verify fields survive packing
+    QVERIFY(sizeof(Card) == 1);
+    QVERIFY(card.getSuit() == CLUBS);
+    QVERIFY(card.getValue() == QUEEN);
+    QVERIFY(!card.isRed());
+    QVERIFY(!card.isFaceUp());
+    QVERIFY(!card.isNull());
+
+    // Flip and confirm suit/value untouched
+    card.flipFaceUp();
+    QVERIFY(card.isFaceUp());
+    QVERIFY(card.getSuit() == CLUBS);
+    QVERIFY(card.getValue() == QUEEN);
+    card.flipFaceDown();
+    QVERIFY(!card.isFaceUp());
+
+    // Null card from empty pile
+    Pile pile(TABLEAU, 0, 0);
+    QVERIFY(pile.topCard().isNull());
+    QVERIFY(pile.pop().isNull());
+}
+
+// Test inline pile storage across ring wrap
+void SWS_Test::testPileStorage()
+{
+    Pile_t src;
+    Pile_t dst;
+
+    // Push to front to force the ring to wrap
+    for (auto v = (int)ACE; v <= KING; v++) src.push_front(Card(HEARTS, (CardValue_t)v));
+    QVERIFY(src.size() == CARDS_PER_STD_SUIT);
+    QVERIFY(src.first().getValue() == KING);
+    QVERIFY(src.last().getValue() == ACE);
+
+    // Splice top 5 cards across and confirm order preserved
+    dst.push_back(Card(SPADES, KING));
+    src.spliceTo(dst, 5);
+    QVERIFY(src.size() == CARDS_PER_STD_SUIT - 5);
+    QVERIFY(dst.size() == 6);
+    QVERIFY(dst[0].getSuit() == SPADES);
+    for (auto i = 1; i < dst.size(); i++) QVERIFY(dst[i].getValue() == 6 - i);
+    QVERIFY(src.last().getValue() == SIX);
+
+    // Pop from both ends
+    src.pop_front();
+    src.pop_back();
+    QVERIFY(src.first().getValue() == QUEEN);
+    QVERIFY(src.last().getValue() == SEVEN);
+    QVERIFY(src.value(src.size(), Card::nullCard()).isNull());
+}
+
+// Test versioned deal generator
+void SWS_Test::testDealGenerator()
+{
+    static const quint8 seed1Top[] = {0x39, 0x37, 0x2c, 0x34, 0x01, 0x28, 0x3c, 0x2b};
+    Deck deck, twin, legacy;
+    int found[CARDS_PER_STD_DECK] = {0};
+
+    // Current generator is fixed; first cards of seed 1 never change
+    QVERIFY(deck.shuffle(1, DEAL_V1) == 1);
+    for (auto i = 0; i < 8; i++) QVERIFY(deck.getCard(i).getCode() == seed1Top[i]);
+
+    // Same seed, same deal; result is a permutation
+    twin.shuffle(1);
+    QVERIFY(deck == twin);
+    for (auto card : deck) found[card.getSuit() * CARDS_PER_STD_SUIT + card.getValue() - 1]++;
+    for (auto i = 0; i < CARDS_PER_STD_DECK; i++) QVERIFY(found[i] == 1);
+
+    // Legacy generator still selectable
+    legacy.shuffle(1, DEAL_LEGACY);
+    QVERIFY(legacy != deck);
+}
+
 // Test basic game object init
 void SWS_Test::testBasicGameInit()
 {
     Game testGame(STD_DECK, stub_checkForWin, stub_processCmd);
 
     // Verify card count
-    QVERIFY(testGame.deck.cardList.size() == CARDS_PER_STD_DECK);
+    QVERIFY(testGame.deck.getCardCount() == CARDS_PER_STD_DECK);
 }
 
 // Test game pile registration
@@ -64,11 +212,13 @@ void SWS_Test::testPileRegistration()
     QVERIFY(testGame.pileMap[DISCARD].size() == 1);
     QVERIFY(testGame.pileMap[DISCARD][0]->pile.size() == 0);
 
-    // Register DECK and confirm cards assigned
-    testGame.registerPile(DECK, 1, 0, 0);
+    // Register DECK and confirm cards assigned; registered piles stay put
+    Pile *pDiscard = testGame.pileMap[DISCARD][0];
+    QVERIFY(testGame.registerPile(DECK, 1, 0, 0) == GS_OK);
     QVERIFY(testGame.pileMap.size() == 2);
     QVERIFY(testGame.pileMap[DECK].size() == 1);
     QVERIFY(testGame.pileMap[DECK][0]->pile.size() == CARDS_PER_STD_DECK);
+    QVERIFY(testGame.pileMap[DISCARD][0] == pDiscard);
 
     // Register 2 FOUNDATION, 3 CELL, 9 TABLEAU piles
     testGame.registerPile(FOUNDATION, 2, 3, 0);
@@ -78,6 +228,15 @@ void SWS_Test::testPileRegistration()
     QVERIFY(testGame.pileMap[FOUNDATION].size() == 2);
     QVERIFY(testGame.pileMap[CELL].size() == 3);
     QVERIFY(testGame.pileMap[TABLEAU].size() == 9);
+    QVERIFY(testGame.pileMap[DISCARD][0] == pDiscard);
+
+    // Only the last type registered can grow; overflow registers nothing
+    QVERIFY(testGame.registerPile(CELL, 1, 9, 0) == GS_ERROR);
+    QVERIFY(testGame.registerPile(TABLEAU, 2, 9, 1) == GS_OK);
+    QVERIFY(testGame.pileMap[TABLEAU].size() == 11);
+    QVERIFY(testGame.registerPile(WASTE, MAX_PILES_PER_TABLE, 0, 2) == GS_PILE_FULL);
+    QVERIFY(!testGame.pileMap.contains(WASTE));
+    QVERIFY(testGame.pileMap.getPileCount() == 18);
 }
 
 // Test card transfers between piles
@@ -85,6 +244,7 @@ void SWS_Test::testCardXfer()
 {
     Game testGame(STD_DECK, stub_checkForWin, stub_processCmd);
     GameError_t status;
+    Card blockBottom, blockTop;
 
     // Register piles
     testGame.registerPile(DECK, 1, 0, 0);
@@ -93,8 +253,12 @@ void SWS_Test::testCardXfer()
     // Move 1 card to TABLEAU pile 0 and 2 cards to TABLEAU pile 2
     status = testGame.moveCard(testGame.pileMap[DECK][0], testGame.pileMap[TABLEAU][0]);
     QVERIFY(status == GS_OK);
+    blockTop = testGame.pileMap[DECK][0]->topCard();
+    blockBottom = testGame.pileMap[DECK][0]->getCard(NEXT);
     status = testGame.moveCards(testGame.pileMap[DECK][0], testGame.pileMap[TABLEAU][2], 2);
     QVERIFY(status == GS_OK);
+    QVERIFY(testGame.pileMap[TABLEAU][2]->bottomCard() == blockBottom); // Block taken from top, order kept
+    QVERIFY(testGame.pileMap[TABLEAU][2]->topCard() == blockTop);
     QVERIFY(testGame.pileMap[TABLEAU][0]->getCardCount() == 1);
     QVERIFY(testGame.pileMap[TABLEAU][1]->getCardCount() == 0);
     QVERIFY(testGame.pileMap[TABLEAU][2]->getCardCount() == 2);
@@ -108,6 +272,531 @@ void SWS_Test::testCardXfer()
     QVERIFY(testGame.pileMap[TABLEAU][3]->getCardCount() == 0);
 }
 
+// Test incremental table hash
+void SWS_Test::testGameHash()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 3);
+    Game twinGame(STD_DECK, stub_checkForWin, stub_processCmd, 3);
+    quint64 dealtHash;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    QVERIFY(KlondikeSetUp(twinGame) == GS_OK);
+    QVERIFY(testGame.checkHash());
+    QVERIFY(testGame.getHash() == twinGame.getHash());
+    dealtHash = testGame.getHash();
+
+    // Move and flip; running hash must track full recompute
+    testGame.moveCards(testGame.pileMap[DECK][0], testGame.pileMap[DISCARD][0], 2);
+    testGame.flipTopCard(testGame.pileMap[DISCARD][0]);
+    QVERIFY(testGame.checkHash());
+    QVERIFY(testGame.getHash() != dealtHash);
+
+    // Undo by hand; hash returns to dealt position
+    testGame.flipTopCard(testGame.pileMap[DISCARD][0], FACE_DOWN);
+    testGame.moveCards(testGame.pileMap[DISCARD][0], testGame.pileMap[DECK][0], 2);
+    QVERIFY(testGame.checkHash());
+    QVERIFY(testGame.getHash() == dealtHash);
+
+    // Same position by a different route
+    testGame.moveCard(testGame.pileMap[TABLEAU][6], testGame.pileMap[FOUNDATION][0]);
+    testGame.moveCard(testGame.pileMap[TABLEAU][5], testGame.pileMap[FOUNDATION][1]);
+    twinGame.moveCard(twinGame.pileMap[TABLEAU][5], twinGame.pileMap[FOUNDATION][1]);
+    twinGame.moveCard(twinGame.pileMap[TABLEAU][6], twinGame.pileMap[FOUNDATION][0]);
+    QVERIFY(testGame.getHash() == twinGame.getHash());
+}
+
+// Test journaled undo/redo
+void SWS_Test::testUndoRedo()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 5);
+    Pile *pDeck, *pDiscard;
+    quint64 dealtHash, drawnHash;
+    Cdb_t cdb;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    pDeck = testGame.pileMap[DECK][0];
+    pDiscard = testGame.pileMap[DISCARD][0];
+    dealtHash = testGame.getHash();
+    QVERIFY(!testGame.canUndo()); // Deal is not journaled
+    QVERIFY(testGame.undo() == GS_NO_HISTORY);
+
+    // Draw three; turned cards land face up in reverse order
+    Card deckTop = pDeck->topCard();
+    QVERIFY(testGame.turnCards(pDeck, pDiscard, 3) == GS_OK);
+    QVERIFY(pDiscard->getCardCount() == 3);
+    QVERIFY(pDiscard->getCardAt(0).getCode() == (deckTop.getCode() | CARD_FACE_UP_BIT));
+    drawnHash = testGame.getHash();
+
+    // Move plus flip as one step
+    testGame.beginStep();
+    testGame.moveCard(testGame.pileMap[TABLEAU][6], testGame.pileMap[FOUNDATION][0]);
+    testGame.flipTopCard(testGame.pileMap[TABLEAU][6]);
+    testGame.endStep();
+    QVERIFY(testGame.getJournalSize() == 3);
+    QVERIFY(testGame.pileMap[TABLEAU][6]->topCard().isFaceUp());
+
+    // Undo step, then draw
+    QVERIFY(testGame.undo() == GS_OK);
+    QVERIFY(testGame.getHash() == drawnHash);
+    QVERIFY(testGame.pileMap[TABLEAU][6]->getCardCount() == 7);
+    QVERIFY(testGame.undo() == GS_OK);
+    QVERIFY(testGame.getHash() == dealtHash);
+    QVERIFY(pDeck->topCard().getCode() == deckTop.getCode());
+    QVERIFY(testGame.checkHash());
+
+    // Redo everything through command path
+    cdb.cmdId = _REDO_CMD;
+    QVERIFY(testGame.processCommand(cdb) == CS_OK);
+    QVERIFY(testGame.processCommand(cdb) == CS_OK);
+    QVERIFY(testGame.processCommand(cdb) == CS_BAD_MOVE);
+    QVERIFY(testGame.pileMap[FOUNDATION][0]->getCardCount() == 1);
+    QVERIFY(testGame.checkHash());
+
+    // New move after undo drops redo branch
+    testGame.undo();
+    testGame.moveCard(pDiscard, testGame.pileMap[FOUNDATION][1]);
+    QVERIFY(!testGame.canRedo());
+    QVERIFY(testGame.getJournalSize() == 2);
+}
+
+// Test re-deal in place and arena reuse over long histories
+void SWS_Test::testGameReset()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 5);
+    Game freshGame(STD_DECK, stub_checkForWin, stub_processCmd, 7);
+    quint64 dealtHash;
+    size_t arenaBytes;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    QVERIFY(KlondikeSetUp(freshGame) == GS_OK);
+    dealtHash = testGame.getHash();
+
+    // History outgrows the inline block; a copy undoes on its own journal
+    drawThrough(testGame, 1000);
+    QVERIFY(testGame.getJournalSize() == 1000);
+    QVERIFY(testGame.getArenaBytes() > ARENA_INLINE_BYTES);
+    Game copyGame(testGame);
+    while (copyGame.canUndo()) copyGame.undo();
+    QVERIFY(copyGame.getHash() == dealtHash);
+    QVERIFY(testGame.getJournalSize() == 1000 && !testGame.canRedo());
+
+    // Reset deals as a new game would, with no history
+    arenaBytes = testGame.getArenaBytes();
+    QVERIFY(testGame.reset(7) == GS_OK);
+    QVERIFY(testGame.getDeckSeed() == 7);
+    QVERIFY(testGame.getHash() == freshGame.getHash());
+    QVERIFY(testGame.computeHash() == testGame.getHash());
+    QVERIFY(!testGame.canUndo() && !testGame.canRedo());
+    for (auto t = 0; t < 7; t++)
+    {
+        QVERIFY(testGame.pileMap[TABLEAU][t]->getCardCount() == freshGame.pileMap[TABLEAU][t]->getCardCount());
+        QVERIFY(testGame.pileMap[TABLEAU][t]->topCard() == freshGame.pileMap[TABLEAU][t]->topCard());
+    }
+
+    // Games replayed in place reuse the arena blocks already held
+    for (auto g = 0; g < 100; g++)
+    {
+        drawThrough(testGame, 1000);
+        QVERIFY(testGame.reset(g + 1) == GS_OK);
+    }
+    QVERIFY(testGame.getArenaBytes() == arenaBytes);
+}
+
+// Test card location index upkeep through moves, turns, flips and history
+void SWS_Test::testCardIndex()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 5);
+    PileMap_t &pileMap = testGame.getPileMap();
+    KlondikeState_t st;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    QVERIFY(PILE_MAP.isIndexed());
+    QVERIFY(indexMatchesTable(pileMap));
+    QVERIFY(PILE_MAP.getCardMask(DECK) != 0 && PILE_MAP.getCardMask(FOUNDATION) == 0);
+
+    // Located card is where the index says
+    Card top = PILE(TABLEAU, 6)->topCard();
+    CardLoc_t loc = PILE_MAP.locate(top);
+    QVERIFY(loc.pile == PILE_MAP.indexOf(PILE(TABLEAU, 6)) && loc.depth == 6);
+    QVERIFY(PILE_MAP.getFaceUpMask() & CARD_BIT(top));
+
+    // Index follows every kind of change, forwards and backwards
+    testGame.turnCards(PILE_DECK, PILE_DISCARD, 3);
+    testGame.moveCards(PILE(TABLEAU, 6), PILE(FOUNDATION, 0), 2);
+    testGame.flipTopCard(PILE(TABLEAU, 6));
+    QVERIFY(indexMatchesTable(pileMap));
+    QVERIFY(PILE_MAP.isCardIn(top, FOUNDATION));
+    while (testGame.undo() == GS_OK) QVERIFY(indexMatchesTable(pileMap));
+    QVERIFY(PILE_MAP.isCardIn(top, TABLEAU));
+    while (testGame.redo() == GS_OK) QVERIFY(indexMatchesTable(pileMap));
+
+    // Restored state is re-indexed
+    memset(&st, 0, sizeof(st));
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++) st.foundation[f] = Card((CardSuit_t)f, KING).getCode();
+    KlondikeStateToGame(st, testGame);
+    QVERIFY(indexMatchesTable(pileMap));
+    QVERIFY(PILE_MAP.getCardMask(FOUNDATION) == CARD_MASK_ALL);
+    QVERIFY((PILE_MAP.getCardMask(FOUNDATION) & SUIT_MASK(HEARTS)) == SUIT_MASK(HEARTS));
+
+    // Repeated card leaves no index
+    PILE(TABLEAU, 0)->push(PILE(FOUNDATION, 0)->topCard());
+    testGame.resync();
+    QVERIFY(!PILE_MAP.isIndexed());
+}
+
+// Test cards-home count and win state kept by moves alone
+void SWS_Test::testWinTracking()
+{
+    Game testGame(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 2);
+    Game stubGame(STD_DECK, stub_checkForWin, stub_processCmd, 2);
+    PileMap_t &pileMap = testGame.getPileMap();
+    KlondikeState_t st;
+
+    // Empty table is not won
+    QVERIFY(testGame.getCardCount() == 0 && !testGame.isGameFinished());
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    QVERIFY(testGame.getCardCount() == CARDS_PER_STD_DECK && testGame.getCardsHome() == 0);
+
+    // All home but the king of spades, which sits on the stock
+    memset(&st, 0, sizeof(st));
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++) st.foundation[f] = Card((CardSuit_t)f, KING).getCode();
+    st.foundation[SPADES] = Card(SPADES, QUEEN).getCode();
+    st.cards[0] = Card(SPADES, KING).getCode();
+    st.stockCount = 1;
+    KlondikeStateToGame(st, testGame);
+    QVERIFY(testGame.getCardsHome() == CARDS_PER_STD_DECK - 1);
+    QVERIFY(!testGame.isGameFinished());
+
+    // Last card home wins on the move, as the rules decide; taking it back does not
+    testGame.turnCards(PILE_DECK, PILE_DISCARD, 1);
+    testGame.moveCard(PILE_DISCARD, PILE(FOUNDATION, SPADES));
+    QVERIFY(testGame.isGameWon());
+    QVERIFY(testGame.undo() == GS_OK);
+    QVERIFY(!testGame.isGameFinished());
+    QVERIFY(testGame.getCardsHome() == CARDS_PER_STD_DECK - 1);
+    QVERIFY(testGame.redo() == GS_OK);
+    QVERIFY(testGame.isGameWon());
+
+    // Rules that never declare a win are not overruled
+    QVERIFY(KlondikeSetUp(stubGame) == GS_OK);
+    KlondikeStateToGame(st, stubGame);
+    stubGame.turnCards(stubGame.getPileMap()[DECK][0], stubGame.getPileMap()[DISCARD][0], 1);
+    stubGame.moveCard(stubGame.getPileMap()[DISCARD][0], stubGame.getPileMap()[FOUNDATION][SPADES]);
+    QVERIFY(stubGame.getCardsHome() == stubGame.getCardCount());
+    QVERIFY(!stubGame.isGameFinished());
+}
+
+// Test compact Klondike state capture and restore
+void SWS_Test::testKlondikeState()
+{
+    Game srcGame(STD_DECK, stub_checkForWin, stub_processCmd, 1);
+    Game dstGame(STD_DECK, stub_checkForWin, stub_processCmd, 2);
+    KlondikeState_t st, st2;
+
+    QVERIFY(KlondikeSetUp(srcGame) == GS_OK);
+    QVERIFY(KlondikeSetUp(dstGame) == GS_OK);
+
+    // Verify opening layout
+    QVERIFY(KlondikeStateFromGame(st, srcGame));
+    QVERIFY(st.stockCount == CARDS_PER_STD_DECK - 28);
+    QVERIFY(st.wasteCount == 0);
+    for (auto p = 0; p < KLONDIKE_TABLEAU_COUNT; p++)
+    {
+        QVERIFY(st.tableauCount[p] == p + 1);
+        QVERIFY(st.faceDownCount[p] == p);
+    }
+
+    // Draw to waste and restore into a differently-seeded game; every card
+    //   comes back with its face state
+    srcGame.turnCards(srcGame.pileMap[DECK][0], srcGame.pileMap[DISCARD][0], 3);
+    QVERIFY(KlondikeStateFromGame(st, srcGame));
+    QVERIFY(st.wasteCount == 3);
+    KlondikeStateToGame(st, dstGame);
+    QVERIFY(KlondikeStateFromGame(st2, dstGame));
+    QVERIFY(KlondikeStateEqual(st, st2));
+    QVERIFY(KlondikeStateHash(st) == KlondikeStateHash(st2));
+    for (auto p = 0; p < dstGame.pileMap.getPileCount(); p++)
+    {
+        Pile *pSrcPile = srcGame.pileMap.at(p);
+        Pile *pDstPile = dstGame.pileMap.at(p);
+        QVERIFY(pDstPile->getCardCount() == pSrcPile->getCardCount());
+        for (auto i = 0; i < pSrcPile->getCardCount(); i++) QVERIFY(pDstPile->getCardAt(i) == pSrcPile->getCardAt(i));
+    }
+
+    // Face states the state cannot imply are refused
+    srcGame.moveCard(srcGame.pileMap[DECK][0], srcGame.pileMap[DISCARD][0]);
+    QVERIFY(!KlondikeStateFromGame(st2, srcGame));
+    srcGame.flipTopCard(srcGame.pileMap[DISCARD][0]);
+    QVERIFY(KlondikeStateFromGame(st2, srcGame));
+    srcGame.flipTopCard(srcGame.pileMap[DECK][0]);
+    QVERIFY(!KlondikeStateFromGame(st2, srcGame));
+
+    // Copied state compares equal; changed state does not
+    memcpy(&st2, &st, sizeof(st));
+    QVERIFY(KlondikeStateEqual(st, st2));
+    st2.foundation[0] = Card(HEARTS, ACE).getCode();
+    QVERIFY(!KlondikeStateEqual(st, st2));
+    QVERIFY(KlondikeStateHash(st) != KlondikeStateHash(st2));
+}
+
+// Test legal move generator against command validation along a playout
+void SWS_Test::testKlondikeLegalMoves()
+{
+    static const PileType_t pileTypes[] = {DECK, DISCARD, FOUNDATION, TABLEAU};
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 3);
+    PileMap_t &pileMap = klondike.getPileMap();
+    KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+    KlondikeState_t st;
+    Cdb_t cdb;
+
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    QVERIFY(KlondikeStateFromGame(st, klondike));
+
+    for (auto step = 0; step < 200; step++)
+    {
+        QVector<quint32> generated;
+        QVector<quint32> validated;
+        int moveCnt = KlondikeStateLegalMoves(st, moves);
+
+        QVERIFY(moveCnt > 0 && moveCnt <= KLONDIKE_MAX_MOVES);
+        for (auto i = 0; i < moveCnt; i++)
+        {
+            const KlondikeMove_t &m = moves[i];
+            generated.append((m.srcType << 24) | (m.srcId << 20) | (m.dstType << 16) | (m.dstId << 12) | m.count);
+        }
+
+        // Every source/destination pair or flip the validator accepts must be
+        //   generated; a flip is a pile to itself
+        KlondikeStateToGame(st, klondike);
+        cdb.cmdId = _FLIP_CMD;
+        for (cdb.src.pileType = TABLEAU, cdb.src.id = 0; cdb.src.id < KLONDIKE_TABLEAU_COUNT; cdb.src.id++)
+        {
+            if (klondikeValidateCmd(pileMap, cdb) != CS_OK) continue;
+            validated.append((TABLEAU << 24) | (cdb.src.id << 20) | (TABLEAU << 16) | (cdb.src.id << 12) | cdb.count);
+        }
+        cdb.cmdId = _MOVE_CMD;
+        for (auto srcType : pileTypes)
+        {
+            for (auto dstType : pileTypes)
+            {
+                for (cdb.src.pileType = srcType, cdb.src.id = 0; cdb.src.id < PILE_VECTOR(srcType).size(); cdb.src.id++)
+                {
+                    for (cdb.dst.pileType = dstType, cdb.dst.id = 0; cdb.dst.id < PILE_VECTOR(dstType).size(); cdb.dst.id++)
+                    {
+                        cdb.count = 0; // Validator's pick
+                        if (klondikeValidateCmd(pileMap, cdb) != CS_OK) continue;
+                        validated.append((srcType << 24) | (cdb.src.id << 20) | (dstType << 16) | (cdb.dst.id << 12) | cdb.count);
+                    }
+                }
+            }
+        }
+        std::sort(generated.begin(), generated.end());
+        std::sort(validated.begin(), validated.end());
+        QVERIFY(generated == validated);
+
+        KlondikeStateApply(st, moves[(step * 7) % moveCnt]);
+    }
+}
+
+// Test dead-end detection on a blocked pile, a pending flip, a hopeless deal
+//   and a winning line
+void SWS_Test::testKlondikeDeadEnd()
+{
+    static const Card blockedPile[] = {Card(CLUBS, SEVEN), Card(SPADES, SEVEN), Card(HEARTS, FOUR), Card(HEARTS, SIX)};
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 7);
+    PileMap_t &pileMap = klondike.getPileMap();
+    KlondikeSolver solver;
+    KlondikeMoveList_t solution;
+    KlondikeState_t st;
+    CardMask_t pileMask = 0;
+    GameConsole console;
+    Cdb_t cdb;
+    int n = 0;
+
+    // 6H over the 4H and both black 7s; every other card in the stock
+    memset(&st, 0, sizeof(st));
+    for (auto card : blockedPile) pileMask |= CARD_BIT(card);
+    for (auto i = 0; i < CARDS_PER_STD_DECK; i++)
+    {
+        Card card((CardSuit_t)(i / CARDS_PER_STD_SUIT), (CardValue_t)(ACE + i % CARDS_PER_STD_SUIT));
+        if (!(pileMask & CARD_BIT(card))) st.cards[n++] = card.getCode();
+    }
+    for (auto card : blockedPile) st.cards[n++] = card.getCode();
+    st.stockCount = CARDS_PER_STD_DECK - 4;
+    st.tableauCount[0] = 4;
+    st.faceDownCount[0] = 3;
+    QVERIFY(KlondikeStateIsDeadEnd(st));
+
+    // Not dead once the 6H is under a black 7
+    std::swap(st.cards[CARDS_PER_STD_DECK - 4], st.cards[CARDS_PER_STD_DECK - 1]);
+    QVERIFY(!KlondikeStateIsDeadEnd(st));
+    std::swap(st.cards[CARDS_PER_STD_DECK - 4], st.cards[CARDS_PER_STD_DECK - 1]);
+
+    // Game reports it as soon as a command lands there; undo takes it back
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    KlondikeStateToGame(st, klondike);
+    cdb.cmdId = _MOVE_CMD;
+    cdb.src.pileType = DECK;
+    cdb.src.id = 0;
+    cdb.dst.pileType = DISCARD;
+    cdb.dst.id = 0;
+    cdb.count = 0;
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    QVERIFY(klondike.getState() == GAME_OVER);
+    klondike.undo();
+    QVERIFY(!klondike.isGameFinished());
+
+    // Hearts home to five, QH in the stock and 6H-JH, KH face down alone on the
+    //   tableau; nothing fits, but the table is not dead while a top can be
+    //   turned up
+    memset(&st, 0, sizeof(st));
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++) st.foundation[f] = Card((CardSuit_t)f, KING).getCode();
+    st.foundation[HEARTS] = Card(HEARTS, FIVE).getCode();
+    st.cards[0] = Card(HEARTS, QUEEN).getCode();
+    st.stockCount = 1;
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        st.cards[1 + t] = Card(HEARTS, (t < 6)? (CardValue_t)(SIX + t) : KING).getCode();
+        st.tableauCount[t] = 1;
+        st.faceDownCount[t] = 1;
+    }
+    QVERIFY(!KlondikeStateIsDeadEnd(st));
+
+    // Game plays on past the draw that strands the QH, and is won
+    KlondikeStateToGame(st, klondike);
+    console.collectInput(cdb, TEST_INPUT("move d0 s0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    QVERIFY(!klondike.isGameFinished());
+    for (auto t = 0; t < KLONDIKE_TABLEAU_COUNT; t++)
+    {
+        QVERIFY(klondike.flipTopCard(PILE(TABLEAU, t)) == GS_OK);
+    }
+    for (auto t = 0; t < 6; t++) QVERIFY(klondike.moveCard(PILE(TABLEAU, t), PILE(FOUNDATION, HEARTS)) == GS_OK);
+    QVERIFY(klondike.moveCard(PILE_DISCARD, PILE(FOUNDATION, HEARTS)) == GS_OK);
+    QVERIFY(klondike.moveCard(PILE(TABLEAU, 6), PILE(FOUNDATION, HEARTS)) == GS_OK);
+    QVERIFY(klondike.isGameWon());
+
+    // Hopeless deal is settled without search
+    QVERIFY(solver.solveSeed(118, solution) == SS_UNSOLVABLE);
+    QVERIFY(solver.getNodeCount() == 0);
+
+    // No position on a winning line is flagged
+    QVERIFY(solver.solveSeed(7, solution) == SS_SOLVED);
+    Game winGame(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 7);
+    QVERIFY(KlondikeSetUp(winGame) == GS_OK);
+    QVERIFY(KlondikeStateFromGame(st, winGame));
+    for (auto move : solution)
+    {
+        QVERIFY(!KlondikeStateIsDeadEnd(st));
+        KlondikeStateApply(st, move);
+    }
+}
+
+// Test Klondike solver on a small endgame
+void SWS_Test::testKlondikeSolver()
+{
+    KlondikeSolver solver;
+    KlondikeMoveList_t solution;
+    KlondikeState_t st;
+
+    // Hearts home to ten; K in stock, J over face-down Q on tableau 0
+    memset(&st, 0, sizeof(st));
+    st.foundation[0] = Card(HEARTS, TEN).getCode();
+    st.foundation[1] = Card(DIAMONDS, KING).getCode();
+    st.foundation[2] = Card(CLUBS, KING).getCode();
+    st.foundation[3] = Card(SPADES, KING).getCode();
+    st.cards[0] = Card(HEARTS, KING).getCode();
+    st.cards[1] = Card(HEARTS, QUEEN).getCode();
+    st.cards[2] = Card(HEARTS, JACK).getCode();
+    st.stockCount = 1;
+    st.tableauCount[0] = 2;
+    st.faceDownCount[0] = 1;
+
+    // Expect J home, Q turned up and home, draw, K home
+    QVERIFY(solver.solve(st, solution) == SS_SOLVED);
+    QVERIFY(solution.size() == 5);
+    QVERIFY(KMOVE_IS_FLIP(solution[1]) && solution[1].srcId == 0);
+    for (auto move : solution) KlondikeStateApply(st, move);
+    QVERIFY(KlondikeStateIsWon(st));
+
+    // Node limit stops search on a full deal
+    Game klondike(STD_DECK, stub_checkForWin, stub_processCmd, 7);
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    solver.setNodeLimit(10);
+    QVERIFY(solver.solve(klondike, solution) == SS_NODE_LIMIT);
+    QVERIFY(solver.getNodeCount() == 10);
+}
+
+// Test hint engine on a small endgame and an opening deal
+void SWS_Test::testKlondikeHint()
+{
+    KlondikeHintEngine engine(2);
+    KlondikeHint_t hint;
+    KlondikeHint_t again;
+    KlondikeMove_t moves[KLONDIKE_MAX_MOVES];
+    KlondikeState_t st;
+    GameConsole console;
+    Cdb_t cdb;
+    bool legal = false;
+
+    // K in stock, J over face-down Q; every deal of the two unseen cards wins
+    //   and starts with the J home
+    memset(&st, 0, sizeof(st));
+    st.foundation[0] = Card(HEARTS, TEN).getCode();
+    st.foundation[1] = Card(DIAMONDS, KING).getCode();
+    st.foundation[2] = Card(CLUBS, KING).getCode();
+    st.foundation[3] = Card(SPADES, KING).getCode();
+    st.cards[0] = Card(HEARTS, KING).getCode();
+    st.cards[1] = Card(HEARTS, QUEEN).getCode();
+    st.cards[2] = Card(HEARTS, JACK).getCode();
+    st.stockCount = 1;
+    st.tableauCount[0] = 2;
+    st.faceDownCount[0] = 1;
+    engine.setSampleCount(16);
+    engine.setTimeBudget(10000);
+    QVERIFY(engine.hint(st, hint));
+    QVERIFY(hint.samples == 16 && hint.wins == 16 && hint.moveWins == 16);
+    QVERIFY(hint.winChance == 1.0);
+    QVERIFY(hint.move.srcType == TABLEAU && hint.move.dstType == FOUNDATION && hint.move.dstId == 0);
+
+    // With the J face down too, the table must first be turned up
+    st.faceDownCount[0] = 2;
+    QVERIFY(engine.hint(st, hint));
+    QVERIFY(hint.wins == 16 && hint.moveWins == 16);
+    QVERIFY(KMOVE_IS_FLIP(hint.move) && hint.move.srcId == 0);
+
+    // Opening deal; hint is legal and repeatable for the same seed
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 7);
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    QVERIFY(KlondikeStateFromGame(st, klondike));
+    engine.setSampleCount(8);
+    engine.setNodeLimit(5000);
+    QVERIFY(engine.hint(st, hint, 99));
+    QVERIFY(hint.samples == 8);
+    if (hint.moveWins != 0)
+    {
+        int moveCnt = KlondikeStateLegalMoves(st, moves);
+        for (auto i = 0; i < moveCnt; i++)
+        {
+            if (memcmp(&moves[i], &hint.move, sizeof(KlondikeMove_t)) == 0) legal = true;
+        }
+        QVERIFY(legal);
+    }
+    QVERIFY(engine.hint(st, again, 99));
+    QVERIFY(again.wins == hint.wins && again.moveWins == hint.moveWins);
+    QVERIFY(memcmp(&again.move, &hint.move, sizeof(KlondikeMove_t)) == 0);
+
+    // Won position has nothing to hint
+    memset(&st, 0, sizeof(st));
+    for (auto f = 0; f < KLONDIKE_FOUNDATION_COUNT; f++) st.foundation[f] = Card((CardSuit_t)f, KING).getCode();
+    QVERIFY(!engine.hint(st, hint));
+
+    // Console parses the command; validator accepts it
+    QVERIFY(console.collectInput(cdb, TEST_INPUT("hint")) == CS_MISSING_ARGS);
+    QVERIFY(cdb.cmdId == _HINT_CMD);
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+}
+
 // Test command line <-> CDB parsing
 void SWS_Test::testConsoleInputParsing()
 {
@@ -179,13 +868,531 @@ void SWS_Test::testConsoleInputParsing()
     QVERIFY(testCdb.src.id == testCdb.arg[0].id);             //
     QVERIFY(testCdb.dst.pileType == testCdb.arg[1].pileType); //
     QVERIFY(testCdb.dst.id == testCdb.arg[1].id);             //
+
+    // Parse mixed case, tabs and multi-digit IDs
+    status = console.collectInput(testCdb, TEST_INPUT("\tMoVe  T10\tf-1 "));
+    QVERIFY(status == CS_OK);
+    QVERIFY(testCdb.cmdId == _MOVE_CMD);
+    QVERIFY(testCdb.arg[0].pileType == TABLEAU);
+    QVERIFY(testCdb.arg[0].id == 10);
+    QVERIFY(testCdb.arg[1].pileType == FOUNDATION);
+    QVERIFY(testCdb.arg[1].id == -1);
+
+    // Parse optional card count; a word after the args that is not one is excess
+    status = console.collectInput(testCdb, TEST_INPUT("move t0 t1 3"));
+    QVERIFY(status == CS_OK && testCdb.count == 3);
+    status = console.collectInput(testCdb, TEST_INPUT("move t0 t1"));
+    QVERIFY(status == CS_OK && testCdb.count == 0);
+    QVERIFY(console.collectInput(testCdb, TEST_INPUT("move t0 t1 0")) == CS_BAD_ARG);
+    QVERIFY(console.collectInput(testCdb, TEST_INPUT("move t0 t1 3x")) == CS_BAD_ARG);
+    QVERIFY(console.collectInput(testCdb, TEST_INPUT("move t0 t1 99999999999")) == CS_BAD_ARG);
+    QVERIFY(console.collectInput(testCdb, TEST_INPUT("move t0 t1 3 4")) == CS_TOO_MANY_ARGS);
+
+    // Parse blank line and near-miss command
+    status = console.collectInput(testCdb, TEST_INPUT("   "));
+    QVERIFY(status == CS_BAD_CMD);
+    QVERIFY(testCdb.cmdId == _INVALID_CMD);
+    status = console.collectInput(testCdb, TEST_INPUT("moved t1 f3"));
+    QVERIFY(status == CS_BAD_CMD);
+    status = console.collectInput(testCdb, TEST_INPUT("move t99999999999 f3"));
+    QVERIFY(status == CS_BAD_ARG);
+    QVERIFY(testCdb.arg[0].id == INVALID_PILE_ID);
+
+    // Line filling the buffer is parsed; a longer one is rejected, not cut short
+    FILE *pInFile = tmpfile();
+    GameConsole fileConsole(stdout, RENDER_FULL, pInFile);
+    fprintf(pInFile, "move t1 f3%*s\n", CONSOLE_LINE_MAX - 11, "");
+    fprintf(pInFile, "move t1 f3%*s3\n", CONSOLE_LINE_MAX, "");
+    fprintf(pInFile, "move t2 f0\n");
+    rewind(pInFile);
+    QVERIFY(fileConsole.collectInput(testCdb) == CS_OK && testCdb.arg[0].id == 1);
+    QVERIFY(fileConsole.collectInput(testCdb) == CS_BAD_CMD && testCdb.cmdId == _INVALID_CMD);
+    QVERIFY(fileConsole.collectInput(testCdb) == CS_OK && testCdb.arg[0].id == 2);
+    QVERIFY(fileConsole.collectInput(testCdb) == CS_END_OF_INPUT);
+    fclose(pInFile);
+}
+
+// Test diff renderer reproduces full frames with far less output
+void SWS_Test::testConsoleDiffRender()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 4);
+    FILE *pDiffFile = tmpfile();
+    FILE *pFullFile = tmpfile();
+    GameConsole diffConsole(pDiffFile, RENDER_DIFF);
+    GameConsole fullConsole(pFullFile);
+    QVector<QByteArray> screen;
+    int fullSize;
+    long pos;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+
+    // First frame is a full redraw
+    testGame.print(diffConsole);
+    applyAnsi(screen, readOutput(pDiffFile, 0));
+    fullSize = diffConsole.getLastOutputSize();
+
+    // Move a card; only changed cells are sent
+    testGame.moveCard(testGame.pileMap[TABLEAU][6], testGame.pileMap[FOUNDATION][0]);
+    testGame.flipTopCard(testGame.pileMap[TABLEAU][6]);
+    pos = ftell(pDiffFile);
+    testGame.print(diffConsole);
+    applyAnsi(screen, readOutput(pDiffFile, pos));
+    QVERIFY(diffConsole.getLastOutputSize() * 10 < fullSize);
+
+    // Screen matches a full render; trailing blanks aside
+    testGame.print(fullConsole);
+    QList<QByteArray> expected = readOutput(pFullFile, 0).split('\n');
+    while (!expected.isEmpty() && expected.last().trimmed().isEmpty()) expected.removeLast();
+    QVERIFY(screen.size() == expected.size());
+    for (auto row = 0; row < screen.size(); row++)
+    {
+        QVERIFY(screen[row].trimmed() == expected[row].trimmed());
+    }
+
+    fclose(pDiffFile);
+    fclose(pFullFile);
+}
+
+// Test cached layout follows table changes
+void SWS_Test::testConsoleLayout()
+{
+    Game testGame(STD_DECK, stub_checkForWin, stub_processCmd, 2);
+    FILE *pNullFile = tmpfile();
+    GameConsole console(pNullFile);
+    Pile *pTallPile;
+
+    QVERIFY(KlondikeSetUp(testGame) == GS_OK);
+    testGame.print(console);
+    QVERIFY(testGame.getDirtyPiles() == 0);
+    QVERIFY(console.layout.pileCount == testGame.pileMap.getPileCount());
+    QVERIFY(console.layout.levelCount == 2);
+
+    // Grow a cascade; only moved piles are dirty
+    pTallPile = testGame.pileMap[TABLEAU][6];
+    testGame.moveCards(testGame.pileMap[DECK][0], pTallPile, 5);
+    testGame.flipTopCard(pTallPile);
+    QVERIFY(testGame.getDirtyPiles() == (PILE_BIT(0) | PILE_BIT(testGame.pileMap.indexOf(pTallPile))));
+    testGame.print(console);
+
+    // Cached layout matches one built from scratch
+    GameConsole freshConsole(pNullFile);
+    freshConsole.printTable(testGame.pileMap);
+    QVERIFY(console.layout.height == freshConsole.layout.height);
+    QVERIFY(console.layout.height > 0);
+    for (auto idx = 0; idx < console.layout.pileCount; idx++)
+    {
+        QVERIFY(console.layout.pileHeight[idx] == freshConsole.layout.pileHeight[idx]);
+    }
+
+    // Shrink back by undo
+    testGame.undo();
+    testGame.undo();
+    testGame.print(console);
+    freshConsole.invalidate();
+    freshConsole.printTable(testGame.pileMap);
+    QVERIFY(console.layout.height == freshConsole.layout.height);
+
+    // Levels that measure nothing take no lines; the deck row moves up to
+    //   the top and stays inside the frame
+    Game sparseGame(STD_DECK, stub_checkForWin, stub_processCmd, 2);
+    sparseGame.registerPile(WASTE, 1, 0, 0);
+    sparseGame.registerPile(DECK, 1, 0, 2);
+    const QByteArray &frame = freshConsole.renderTable(sparseGame.pileMap);
+    QVERIFY(freshConsole.layout.levelCount == 3);
+    QVERIFY(freshConsole.layout.levelTop[2] == 0);
+    QVERIFY(frame.size() == freshConsole.layout.height * freshConsole.layout.width);
+    QVERIFY(memcmp(frame.constData() + freshConsole.layout.width, " ----- ", 7) == 0);
+
+    fclose(pNullFile);
 }
 
 // Test command processing
 void SWS_Test::testCommandProcessing()
 {
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 7);
+    PileMap_t &pileMap = klondike.getPileMap();
+    GameConsole console;
+    KlondikeSolver solver;
+    KlondikeMoveList_t solution;
+    Cdb_t cdb;
+
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    QVERIFY(solver.solve(klondike, solution) == SS_SOLVED);
+
+    // Rejected commands leave table and journal untouched
+    console.collectInput(cdb, TEST_INPUT("move t0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_MISSING_ARGS);
+    console.collectInput(cdb, TEST_INPUT("move t9 f0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_BAD_ARG_1);
+    console.collectInput(cdb, TEST_INPUT("move s0 d0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_BAD_MOVE); // Nothing to recycle
+    console.collectInput(cdb, TEST_INPUT("flip t3"));
+    QVERIFY(klondike.processCommand(cdb) == CS_BAD_MOVE); // Already face up
+    QVERIFY(!klondike.canUndo());
+
+    // Draw turns stock top onto waste; undone as one step
+    console.collectInput(cdb, TEST_INPUT("move d0 s0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    QVERIFY(PILE_DECK->getCardCount() == 23);
+    QVERIFY(PILE_DISCARD->topCard().isFaceUp());
+    console.collectInput(cdb, TEST_INPUT("undo"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    QVERIFY(PILE_DECK->getCardCount() == 24 && PILE_DISCARD->getCardCount() == 0);
+
+    // Solver line, flips included, replayed as commands wins
+    QVERIFY(replaySolution(klondike, solution));
+    QVERIFY(klondike.isGameWon());
+
+    // Undo leaves the won table
+    console.collectInput(cdb, TEST_INPUT("undo"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    QVERIFY(!klondike.isGameFinished());
+}
+
+// Test multi-deck decks and the deal methods of the variants
+void SWS_Test::testVariantDeals()
+{
+    Deck spiderDeck(ONE_SUIT_DECK, 8);
+    Game fanGame(STD_DECK, stub_checkForWin, stub_processCmd, 3);
+    RulesGame<FreeCellRules> freeCell(5);
+    RulesGame<Spider2Rules> spider(5);
+    int valueCount[CARDS_PER_STD_SUIT + 1] = {0};
+
+    // Eight copies of one suit make up a Spider deck
+    QVERIFY(spiderDeck.getCardCount() == SPIDER_CARD_COUNT);
+    for (auto card : spiderDeck) valueCount[card.getValue()]++;
+    for (auto v = (int)ACE; v <= (int)KING; v++) QVERIFY(valueCount[v] == 8);
+
+    // Decrementing deal ends; pile 'n' gets '7 - n' cards, top face up
+    fanGame.registerPile(DECK, 1, 0, 0);
+    fanGame.registerPile(TABLEAU, 7, 0, 1);
+    QVERIFY(fanGame.deal(FOUNDATION, ALL) == GS_ERROR); // No such piles
+    QVERIFY(fanGame.deal(TABLEAU, DECREMENTING) == GS_OK);
+    for (auto t = 0; t < 7; t++)
+    {
+        Pile *pPile = fanGame.getPileMap()[TABLEAU][t];
+        QVERIFY(pPile->getCardCount() == 7 - t);
+        QVERIFY(pPile->topCard().isFaceUp() && !pPile->getCard(NEXT).isFaceUp());
+    }
+    QVERIFY(fanGame.getPileMap()[DECK][0]->getCardCount() == CARDS_PER_STD_DECK - 28);
+
+    // FreeCell: whole deck face up, 7 cards to the first four piles, 6 to the rest
+    QVERIFY(freeCell.setUp() == GS_OK);
+    QVERIFY(freeCell.getPileMap()[DECK][0]->getCardCount() == 0);
+    for (auto t = 0; t < FREECELL_TABLEAU_COUNT; t++)
+    {
+        Pile *pPile = freeCell.getPileMap()[TABLEAU][t];
+        QVERIFY(pPile->getCardCount() == ((t < 4)? 7 : 6));
+        for (auto i = 0; i < pPile->getCardCount(); i++) QVERIFY(pPile->getCardAt(i).isFaceUp());
+    }
+    QVERIFY(freeCell.getPileMap().isIndexed());
+
+    // Spider: 54 cards round robin, tops face up, 50 left in the stock
+    QVERIFY(spider.setUp() == GS_OK);
+    QVERIFY(spider.getCardCount() == SPIDER_CARD_COUNT);
+    QVERIFY(spider.getPileMap()[DECK][0]->getCardCount() == SPIDER_CARD_COUNT - SPIDER_DEAL_COUNT);
+    for (auto t = 0; t < SPIDER_TABLEAU_COUNT; t++)
+    {
+        Pile *pPile = spider.getPileMap()[TABLEAU][t];
+        QVERIFY(pPile->getCardCount() == ((t < 4)? 6 : 5));
+        QVERIFY(pPile->topCard().isFaceUp() && !pPile->getCard(NEXT).isFaceUp());
+    }
+    QVERIFY(!spider.getPileMap().isIndexed()); // Duplicate cards
+    QVERIFY(spider.checkHash());
+}
+
+// Test generic solver on FreeCell and Spider deals
+void SWS_Test::testRulesSolver()
+{
+    RulesSolver<FreeCellRules> freeCellSolver;
+    RulesSolver<Spider1Rules> spiderSolver;
+    RulesSolver<Spider4Rules> spider4Solver;
+    RulesGame<FreeCellRules> freeCell(10);
+    RulesGame<Spider1Rules> spider(3);
+    GameMoveList_t solution;
+
+    // Solution replays to a win, one move per undo step
+    QVERIFY(freeCell.setUp() == GS_OK);
+    QVERIFY(freeCellSolver.solve(freeCell, solution) == SS_SOLVED);
+    for (auto move : solution)
+    {
+        freeCell.beginStep();
+        FreeCellRules::playMove(freeCell, move);
+        freeCell.endStep();
+    }
+    QVERIFY(freeCell.isGameWon());
+    QVERIFY(freeCell.getJournalSize() == solution.size());
+    QVERIFY(freeCellSolver.getBestHome() == CARDS_PER_STD_DECK);
+
+    QVERIFY(spider.setUp() == GS_OK);
+    QVERIFY(spiderSolver.solve(spider, solution) == SS_SOLVED);
+    for (auto move : solution) Spider1Rules::playMove(spider, move);
+    QVERIFY(spider.isGameWon());
+    QVERIFY(spider.checkHash());
+
+    // Moves that play nothing are passed over, not taken back
+    RulesSolver<IdleFreeCellRules> idleSolver;
+    RulesGame<IdleFreeCellRules> idleFreeCell(10);
+    QVERIFY(idleFreeCell.setUp() == GS_OK);
+    QVERIFY(idleSolver.solve(idleFreeCell, solution) == SS_SOLVED);
+    for (auto move : solution) IdleFreeCellRules::playMove(idleFreeCell, move);
+    QVERIFY(idleFreeCell.isGameWon());
+
+    // Solver works on a copy; node limit stops search
+    QVERIFY(spiderSolver.solveSeed(3, solution) == SS_SOLVED);
+    spider4Solver.setNodeLimit(10);
+    QVERIFY(spider4Solver.solveSeed(1, solution) == SS_NODE_LIMIT);
+    QVERIFY(spider4Solver.getNodeCount() == 10);
+}
+
+// Test compile-time rules game against the function-pointer game
+void SWS_Test::testRulesGame()
+{
+    Game klondike(STD_DECK, klondikeCheckForWin, klondikeValidateCmd, 7);
+    RulesGame<KlondikeRules> rulesGame(7);
+    Game &rulesBase = rulesGame;
+    PileMap_t &pileMap = rulesGame.getPileMap();
+    GameConsole console;
+    KlondikeSolver solver;
+    KlondikeMoveList_t solution;
+    Cdb_t cdb;
+
+    // Same deck, piles and deal
+    QVERIFY(KlondikeSetUp(klondike) == GS_OK);
+    QVERIFY(rulesGame.setUp() == GS_OK);
+    QVERIFY(rulesGame.getHash() == klondike.getHash());
+    QVERIFY(PILE_MAP.getPileCount() == klondike.getPileMap().getPileCount());
+    QVERIFY(solver.solve(rulesGame, solution) == SS_SOLVED);
+
+    // Same verdicts on bad commands
+    console.collectInput(cdb, TEST_INPUT("move s0 d0"));
+    QVERIFY(rulesGame.processCommand(cdb) == klondike.processCommand(cdb));
+    console.collectInput(cdb, TEST_INPUT("move t9 f0"));
+    QVERIFY(rulesGame.processCommand(cdb) == klondike.processCommand(cdb));
+
+    // Solver line gives the same tables step by step, whether the rules game
+    //   is driven through its base or directly
+    QVERIFY(replaySolution(rulesBase, solution, &klondike));
+    QVERIFY(rulesGame.isGameWon() && klondike.isGameWon());
+    QVERIFY(rulesGame.reset(7) == GS_OK && klondike.reset(7) == GS_OK);
+    QVERIFY(replaySolution(rulesGame, solution, &klondike));
+    QVERIFY(rulesGame.isGameWon() && klondike.isGameWon());
+
+    // History commands recheck the win through the rules
+    console.collectInput(cdb, TEST_INPUT("undo"));
+    QVERIFY(rulesGame.processCommand(cdb) == CS_OK);
+    QVERIFY(!rulesGame.isGameFinished());
+
+    // Last card home outside a command is still judged by the rules class,
+    //   not the base's pointer
+    rulesGame.ruleFuncs.checkForWin = nullptr;
+    QVERIFY(rulesGame.redo() == GS_OK);
+    QVERIFY(rulesGame.isGameWon());
+}
+
+// Test FreeCell and Spider commands, and a solver line replayed as commands
+void SWS_Test::testVariantCommands()
+{
+    RulesGame<FreeCellRules> freeCell(10);
+    RulesGame<Spider1Rules> spider(3);
+    PileMap_t *pPileMap = &freeCell.getPileMap();
+    RulesSolver<Spider1Rules> solver;
+    GameMoveList_t solution;
+    GameConsole console;
+    Cdb_t cdb;
+
+    // FreeCell: one card per cell, no stock to deal from
+    QVERIFY(freeCell.setUp() == GS_OK);
+    console.collectInput(cdb, TEST_INPUT("move t0 c0"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK);
+    console.collectInput(cdb, TEST_INPUT("move t1 c0"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("move c0 c1"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK);
+    console.collectInput(cdb, TEST_INPUT("deal"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("hint"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK);
+    QVERIFY((*pPileMap)[CELL][1]->getCardCount() == 1 && (*pPileMap)[TABLEAU][0]->getCardCount() == 6);
+
+    // FreeCell: 9H 8S 7H moves whole to an empty pile unless a count is given
+    for (auto pPile : *pPileMap) pPile->clear();
+    for (auto v = NINE; v >= SEVEN; v = (CardValue_t)(v - 1)) (*pPileMap)[TABLEAU][0]->push(Card((v == EIGHT)? SPADES : HEARTS, v, FACE_UP));
+    (*pPileMap)[TABLEAU][2]->push(Card(CLUBS, TEN, FACE_UP));
+    freeCell.resync();
+    console.collectInput(cdb, TEST_INPUT("move t0 t1 2"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK && cdb.count == 2);
+    QVERIFY(freeCell.undo() == GS_OK);
+    console.collectInput(cdb, TEST_INPUT("move t0 t1 4"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("move t0 t2 2"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("move t0 t1"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK && cdb.count == 3);
+    console.collectInput(cdb, TEST_INPUT("move t1 t2 3"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_OK && cdb.count == 3);
+    console.collectInput(cdb, TEST_INPUT("move t2 c0 2"));
+    QVERIFY(freeCell.processCommand(cdb) == CS_BAD_MOVE);
+
+    // Spider: deal turns one card onto every pile as one step; no partial run goes home
+    PileMap_t &pileMap = spider.getPileMap();
+    QVERIFY(spider.setUp() == GS_OK);
+    console.collectInput(cdb, TEST_INPUT("deal"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK);
+    QVERIFY(PILE_DECK->getCardCount() == SPIDER_CARD_COUNT - SPIDER_DEAL_COUNT - SPIDER_TABLEAU_COUNT);
+    for (auto pPile : PILE_VECTOR(TABLEAU)) QVERIFY(pPile->topCard().isFaceUp());
+    console.collectInput(cdb, TEST_INPUT("undo"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK);
+    QVERIFY(PILE_DECK->getCardCount() == SPIDER_CARD_COUNT - SPIDER_DEAL_COUNT);
+    console.collectInput(cdb, TEST_INPUT("hint"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK && spider.canRedo()); // Leaves table and history alone
+    console.collectInput(cdb, TEST_INPUT("move t0 f0"));
+    QVERIFY(spider.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("flip t0"));
+    QVERIFY(spider.processCommand(cdb) == CS_BAD_MOVE);
+
+    // Deal that runs out of stock part way is taken back whole
+    QVERIFY(spider.moveCards(PILE_DECK, PILE(FOUNDATION, 0), PILE_DECK->getCardCount() - 5) == GS_OK);
+    quint64 shortHash = spider.getHash();
+    int shortJournal = spider.getJournalSize();
+    spider.beginStep();
+    QVERIFY(Spider1Rules::dealStock(spider) == GS_EMPTY_PILE);
+    spider.cancelStep();
+    QVERIFY(spider.getHash() == shortHash && spider.checkHash());
+    QVERIFY(spider.getJournalSize() == shortJournal && PILE_DECK->getCardCount() == 5);
+    QVERIFY(spider.undo() == GS_OK && !spider.canUndo());
+
+    // Solver line, flips and deals included, replayed as commands wins
+    QVERIFY(solver.solve(spider, solution) == SS_SOLVED);
+    QVERIFY(replaySolution(spider, solution));
+    QVERIFY(spider.isGameWon());
+
+    // Spider: 9S 8S 7S moves whole to an empty pile unless a count is given
+    for (auto pPile : PILE_MAP) pPile->clear();
+    for (auto v = NINE; v >= SEVEN; v = (CardValue_t)(v - 1)) PILE(TABLEAU, 0)->push(Card(SPADES, v, FACE_UP));
+    PILE(TABLEAU, 2)->push(Card(HEARTS, NINE, FACE_UP));
+    spider.resync();
+    console.collectInput(cdb, TEST_INPUT("move t0 t1 2"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK && cdb.count == 2);
+    QVERIFY(PILE(TABLEAU, 0)->getCardCount() == 1 && PILE(TABLEAU, 1)->topCard().getValue() == SEVEN);
+    QVERIFY(spider.undo() == GS_OK);
+    console.collectInput(cdb, TEST_INPUT("move t0 t1 4"));
+    QVERIFY(spider.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("move t0 t2 1"));
+    QVERIFY(spider.processCommand(cdb) == CS_BAD_MOVE);
+    console.collectInput(cdb, TEST_INPUT("move t0 t2 2"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK && cdb.count == 2);
+    console.collectInput(cdb, TEST_INPUT("move t0 t1"));
+    QVERIFY(spider.processCommand(cdb) == CS_OK && cdb.count == 1);
+}
+
+#ifdef Q_OS_UNIX
+// Test server sessions over a local socket
+void SWS_Test::testGameServer()
+{
+    GameServer server(1, 4);
+    RulesGame<KlondikeRules> klondike(7);
+    PileMap_t &pileMap = klondike.getPileMap();
+    GameConsole console;
+    Cdb_t cdb;
+    char path[64];
+    char expect[64];
+    int opened = 0;
 
+    snprintf(path, sizeof(path), "/tmp/sws_test_%d.sock", (int)getpid());
+    QVERIFY(server.listen(path));
+    std::thread loop(&GameServer::run, &server);
+    int fd = serverConnect(path);
+    QVERIFY(fd >= 0);
+
+    // Commands run through the rules; replies carry status, state, cards home and hash
+    QVERIFY(klondike.setUp() == GS_OK);
+    QVERIFY(serverRequest(fd, "open klondike 7") == "ok 0 klondike 7");
+    console.collectInput(cdb, TEST_INPUT("move d0 s0"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    snprintf(expect, sizeof(expect), "0 0 0 0/52 %016llx", (unsigned long long)klondike.getHash());
+    QVERIFY(serverRequest(fd, "0 move d0 s0") == expect);
+    QVERIFY(serverRequest(fd, "0 move t9 f0").startsWith("0 11 ")); // CS_BAD_ARG_1
+    QVERIFY(serverRequest(fd, "0 hint").startsWith("0 1 "));        // CS_BAD_CMD
+    QVERIFY(serverRequest(fd, "open spider2 5") == "ok 1 spider2 5");
+    QVERIFY(serverRequest(fd, "1 deal").startsWith("1 0 0 0/104 "));
+    QVERIFY(serverRequest(fd, "open nosuch") == "err bad variant");
+    QVERIFY(serverRequest(fd, "shuffle") == "err bad request");
+
+    // Slots run out; a closed session's game is reused and dealt afresh
+    QVERIFY(serverRequest(fd, "open 3").startsWith("ok 2 klondike 3"));
+    QVERIFY(serverRequest(fd, "open").startsWith("ok 3 klondike"));
+    QVERIFY(serverRequest(fd, "open") == "err session limit");
+    QVERIFY(serverRequest(fd, "close 0") == "ok 0");
+    QVERIFY(serverRequest(fd, "0 undo") == "err bad session");
+    QVERIFY(serverRequest(fd, "open klondike 7") == "ok 0 klondike 7");
+    console.collectInput(cdb, TEST_INPUT("undo"));
+    QVERIFY(klondike.processCommand(cdb) == CS_OK);
+    snprintf(expect, sizeof(expect), "0 20 0 0/52 %016llx", (unsigned long long)klondike.getHash());
+    QVERIFY(serverRequest(fd, "0 undo") == expect); // Nothing to undo on the new deal
+    QVERIFY(PILE_DECK->getCardCount() == 24);
+
+    // Sessions belong to their connection and end with it
+    int other = serverConnect(path);
+    QVERIFY(other >= 0);
+    QVERIFY(serverRequest(other, "1 deal") == "err bad session");
+    close(fd);
+    for (auto tries = 0; tries < 1000 && opened < 4; tries++)
+    {
+        if (serverRequest(other, "open freecell").startsWith("ok ")) opened++;
+        else usleep(1000);
+    }
+    QVERIFY(opened == 4);
+    close(other);
+
+    // A client that stops reading holds up neither the loop nor the worker; its
+    //   input is left unread until it reads its replies, none of which are lost
+    static const char undoLine[] = "0 undo\n";
+    QByteArray burst;
+    int lines = 0;
+    char buf[4096];
+    int replies = 0;
+    int slow = serverConnect(path);
+    QVERIFY(slow >= 0);
+    fcntl(slow, F_SETFL, fcntl(slow, F_GETFL) | O_NONBLOCK);
+    for (auto i = 0; i < 1000; i++) burst.append(undoLine);
+    for (auto tries = 0; tries < 3; )
+    {
+        // Until the server has stopped taking input for a while
+        ssize_t n = send(slow, burst.constData(), burst.size(), 0);
+        if (n > 0)
+        {
+            lines += n / (sizeof(undoLine) - 1);
+            tries = 0;
+        }
+        else
+        {
+            tries++;
+            usleep(10000);
+        }
+    }
+    int quick = serverConnect(path);
+    QVERIFY(quick >= 0);
+    auto start = std::chrono::steady_clock::now();
+    QVERIFY(serverRequest(quick, "0 undo") == "err bad session");
+    QVERIFY(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    close(quick);
+    for (;;)
+    {
+        pollfd pfd = {slow, POLLIN, 0};
+        if (poll(&pfd, 1, 2000) <= 0) break;
+        ssize_t n = recv(slow, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        for (auto i = 0; i < n; i++) replies += (buf[i] == '\n');
+        if (replies == lines) break;
+    }
+    QVERIFY(replies == lines);
+    close(slow);
+
+    server.stop();
+    loop.join();
 }
+#endif
 
 
 ////////////////////////
@@ -197,11 +1404,174 @@ void stub_checkForWin(PileMap_t &, GameState_t &)
 }
 
 // Process command stub
-CmdError_t stub_processCmd(Cdb_t &)
+CmdError_t stub_processCmd(PileMap_t &, Cdb_t &)
 {
     return CS_ERROR;
 }
 
+// Card location index agrees with a scan of every pile
+bool indexMatchesTable(PileMap_t &pileMap)
+{
+    CardMask_t faceUpMask = 0;
+    CardMask_t typeMask[INVALID_PILE_TYPE] = {0};
+
+    for (auto idx = 0; idx < PILE_MAP.getPileCount(); idx++)
+    {
+        Pile *pPile = PILE_MAP.at(idx);
+        for (auto depth = 0; depth < pPile->getCardCount(); depth++)
+        {
+            Card card = pPile->getCardAt(depth);
+            CardLoc_t loc = PILE_MAP.locate(card);
+            if (loc.pile != idx || loc.depth != depth) return false;
+            typeMask[pPile->getType()] |= CARD_BIT(card);
+            if (card.isFaceUp()) faceUpMask |= CARD_BIT(card);
+        }
+    }
+    for (auto t = 0; t < INVALID_PILE_TYPE; t++)
+    {
+        if (PILE_MAP.getCardMask((PileType_t)t) != typeMask[t]) return false;
+    }
+
+    return PILE_MAP.getFaceUpMask() == faceUpMask;
+}
+
+// Journal 'steps' draws of one card, turning the discards back when the deck
+//   runs out
+void drawThrough(Game &game, int steps)
+{
+    Pile *pDeck = game.pileMap[DECK][0];
+    Pile *pDiscard = game.pileMap[DISCARD][0];
+
+    for (auto i = 0; i < steps; i++)
+    {
+        if (pDeck->getCardCount() == 0) game.turnCards(pDiscard, pDeck, pDiscard->getCardCount());
+        else game.turnCards(pDeck, pDiscard, 1);
+    }
+}
+
+// Replay a solver line as commands, flips and deals included; each must run
+//   as generated, and a twin game, if given, must keep the same table
+template <class G, class M>
+bool replaySolution(G &game, const QVector<M> &solution, Game *pTwin)
+{
+    static const char pileLetter[] = "DSWFCT";
+    GameConsole console;
+    Cdb_t cdb;
+    char cmdStr[32];
+    int len;
+
+    for (auto move : solution)
+    {
+        if (move.srcType == DECK && move.dstType == TABLEAU) len = sprintf(cmdStr, "deal");
+        else if (move.srcType == TABLEAU && move.dstType == TABLEAU && move.srcId == move.dstId) len = sprintf(cmdStr, "flip t%d", move.srcId);
+        else len = sprintf(cmdStr, "move %c%d %c%d", pileLetter[move.srcType], move.srcId, pileLetter[move.dstType], move.dstId);
+        console.tokenize(cdb, cmdStr, len); // Args left missing are checked by validation
+        if (game.processCommand(cdb) != CS_OK || cdb.count != move.count) return false;
+        if (pTwin != nullptr && (pTwin->processCommand(cdb) != CS_OK || pTwin->getHash() != game.getHash())) return false;
+    }
+
+    return true;
+}
+
+// Read everything written to file from 'pos' on
+QByteArray readOutput(FILE *pFile, long pos)
+{
+    QByteArray bytes;
+    long end;
+
+    fflush(pFile);
+    end = ftell(pFile);
+    bytes.resize(end - pos);
+    fseek(pFile, pos, SEEK_SET);
+    if (fread(bytes.data(), 1, bytes.size(), pFile) != (size_t)bytes.size()) bytes.clear();
+    fseek(pFile, end, SEEK_SET);
+
+    return bytes;
+}
+
+#ifdef Q_OS_UNIX
+// Connect to server socket; '-1' on failure
+int serverConnect(const char *pPath)
+{
+    sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, pPath, sizeof(addr.sun_path) - 1);
+    if (fd >= 0 && ::connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+// Send request line and read the reply line, without its newline
+QByteArray serverRequest(int fd, const char *pLine)
+{
+    QByteArray reply;
+    char c;
+
+    if (send(fd, pLine, strlen(pLine), 0) < 0 || send(fd, "\n", 1, 0) < 0) return reply;
+    while (recv(fd, &c, 1, 0) == 1 && c != '\n') reply.append(c);
+
+    return reply;
+}
+#endif
+
+// Play console output onto a screen of lines; handles the cursor and erase
+//   sequences used by the diff renderer
+void applyAnsi(QVector<QByteArray> &screen, const QByteArray &bytes)
+{
+    int row = 0;
+    int col = 0;
+
+    for (auto i = 0; i < bytes.size(); i++)
+    {
+        if (bytes[i] == '\n')
+        {
+            row++;
+            col = 0;
+        }
+        else if (bytes[i] == '\x1b')
+        {
+            int arg[2] = {0, 0};
+            int a = 0;
+
+            for (i += 2; bytes[i] == ';' || isdigit(bytes[i]); i++)
+            {
+                if (bytes[i] == ';') a++;
+                else arg[a] = arg[a] * 10 + (bytes[i] - '0');
+            }
+            if (bytes[i] == 'H')
+            {
+                row = (arg[0] > 0)? arg[0] - 1 : 0;
+                col = (arg[1] > 0)? arg[1] - 1 : 0;
+            }
+            else if (bytes[i] == 'J')
+            {
+                if (arg[0] == 2) screen.clear();
+                else
+                {
+                    if (row < screen.size()) screen[row].truncate(col);
+                    while (screen.size() > row + 1) screen.removeLast();
+                }
+            }
+        }
+        else
+        {
+            while (screen.size() <= row) screen.append(QByteArray());
+            while (screen[row].size() <= col) screen[row].append(' ');
+            screen[row][col++] = bytes[i];
+        }
+    }
+
+    // Drop empty trailing rows left by erases
+    while (!screen.isEmpty() && screen.last().trimmed().isEmpty()) screen.removeLast();
+}
+
 
 QTEST_APPLESS_MAIN(SWS_Test)
 